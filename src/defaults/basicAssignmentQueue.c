@@ -3,52 +3,200 @@
 #include <stdio.h>
 
 #define RB_QUEUE_INDEX_UNQUEUED -1
+// The number of coords a priority level has room for when it's first used.
+#define RB_QUEUE_INITIAL_LEVEL_CAPACITY 64
+
+// Tiled sampling cuts the canvas into square tiles, 2^RB_QUEUE_TILE_SHIFT coords on a side. A 32x32 tile's pixels and
+// queue entries fit in L2 together.
+#define RB_QUEUE_TILE_SHIFT 5
+#define RB_QUEUE_TILE_SIZE (1 << RB_QUEUE_TILE_SHIFT)
+#define RB_QUEUE_TILE_AREA (RB_QUEUE_TILE_SIZE * RB_QUEUE_TILE_SIZE)
+// Tiled sampling moves on to a random tile once every this many choices, on average.
+#define RB_QUEUE_TILE_LEAVE_ODDS 16
+#define RB_QUEUE_TILE_NONE -1
+
+/*
+A bucketed priority queue. Every priority level has its own unordered array of coords, stored as RB_PixelIndexes so
+four fit in the space of one RB_Coord, and nonEmptyLevels has bit i
+set whenever level i has any coords, so the best non-empty level is always its lowest set bit. Coords are removed by
+moving the level's last coord into their place, which keeps every operation O(1).
+
+Every queued coord also has a weight, stored alongside it in its level. In weighted sampling mode, each level keeps a
+Fenwick tree over its slots' weights, so a coord can be chosen with probability proportional to its weight, and a
+slot's weight can be changed, in O(log n) time.
+
+In tiled sampling mode, each tile of the canvas also keeps an unordered array of the queued coords inside it. Most
+choices are made from the tile of the previous choice, whose pixels are still in cache. The rest are uniform over the
+whole level, which is the same as picking a tile in proportion to how many coords it has queued and then a coord
+inside it. That moves the work to a new tile, so the spread of choices over the whole canvas stays uniform.
+*/
+// The tables indexed by pixel index, which RB_createSharedAssignmentQueue shares between queues.
+typedef struct {
+	int numQueues;
+	// Allocated while any of the queues uses tiled sampling.
+	uint16_t* coordTileSlots;
+	int numTiledQueues;
+
+	int32_t* coordIndexes;
+	uint8_t* coordLevels;
+} PixelTables;
 
 struct RB_AssignmentQueue_s {
-	RB_Coord* coords;
+	RB_PixelIndex* levelPixels[RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES];
+	RB_Size levelLens[RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES];
+	RB_Size levelCapacities[RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES];
+	uint64_t nonEmptyLevels;
+
+	// The weight of each slot in each level.
+	uint32_t* levelWeights[RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES];
+	// A Fenwick tree over each level's slot weights, indexed from 1 and levelCapacities[level] long. All NULL unless
+	// sampling is RB_QUEUE_SAMPLING_WEIGHTED.
+	uint64_t* levelWeightTrees[RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES];
+	RB_QueueSampling sampling;
+
+	// Only allocated when sampling is RB_QUEUE_SAMPLING_TILED. Tile t's queued coords are stored as offsets within the
+	// tile, in tileCoords[t * RB_QUEUE_TILE_AREA] onwards, and coordTileSlots holds each queued coord's index in its
+	// tile's array, indexed by pixel index. coordTileSlots belongs to pixelTables.
+	uint16_t* tileCoords;
+	RB_Size* tileLens;
+	uint16_t* coordTileSlots;
+	RB_Size numTileRows;
+	// The tile the last coord was chosen from, or RB_QUEUE_TILE_NONE.
+	RB_Size lastTile;
+
 	RB_Size coordLen;
 	RB_Size maxCoordLen;
 
-	RB_Size** coordIndexes;
+	// The index of each queued coord within its level, or RB_QUEUE_INDEX_UNQUEUED, indexed by pixel index.
+	int32_t* coordIndexes;
+	// The level of each queued coord, indexed by pixel index. Only meaningful for queued coords.
+	uint8_t* coordLevels;
+	PixelTables* pixelTables;
 	RB_Size xRange;
 	RB_Size yRange;
 };
 
-// Allocates an assignmentQueue capable of storing the specified number of pixels.
-RB_AssignmentQueue* RB_createAssignmentQueue(RB_Size size, RB_Size xRange, RB_Size yRange) {
-	RB_AssignmentQueue* ret = malloc(
-		sizeof(RB_AssignmentQueue)
-		+ (sizeof(RB_Coord) * size)
-		+ (sizeof(RB_Size*) * xRange)
-		+ (sizeof(RB_Size) * xRange * yRange)
+PixelTables* createPixelTables(RB_Size xRange, RB_Size yRange) {
+	PixelTables* ret = malloc(
+		sizeof(PixelTables)
+		+ (sizeof(int32_t) * xRange * yRange)
+		+ (sizeof(uint8_t) * xRange * yRange)
 	);
 
 	if(ret == NULL) {
 		return NULL;
 	}
 
-	ret->coords = (RB_Coord*) (ret + 1);
+	ret->numQueues = 0;
+	ret->coordTileSlots = NULL;
+	ret->numTiledQueues = 0;
+	ret->coordIndexes = (int32_t*) (ret + 1);
+	ret->coordLevels = (uint8_t*) (ret->coordIndexes + (xRange * yRange));
+
+	for(RB_Size i = 0; i < xRange * yRange; i++) {
+		ret->coordIndexes[i] = RB_QUEUE_INDEX_UNQUEUED;
+	}
+
+	return ret;
+}
+
+RB_AssignmentQueue* createQueueWithPixelTables(RB_Size size, RB_Size xRange, RB_Size yRange, PixelTables* tables) {
+	RB_AssignmentQueue* ret = malloc(sizeof(RB_AssignmentQueue));
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	// The levels' arrays are allocated the first time each level is used.
+	for(int level = 0; level < RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES; level++) {
+		ret->levelPixels[level] = NULL;
+		ret->levelLens[level] = 0;
+		ret->levelCapacities[level] = 0;
+		ret->levelWeights[level] = NULL;
+		ret->levelWeightTrees[level] = NULL;
+	}
+	ret->nonEmptyLevels = 0;
+	ret->sampling = RB_QUEUE_SAMPLING_UNIFORM;
+	ret->tileCoords = NULL;
+	ret->tileLens = NULL;
+	ret->coordTileSlots = NULL;
+	ret->numTileRows = (yRange + RB_QUEUE_TILE_SIZE - 1) >> RB_QUEUE_TILE_SHIFT;
+	ret->lastTile = RB_QUEUE_TILE_NONE;
+
 	ret->maxCoordLen = size;
 	ret->coordLen = 0;
 
-	ret->coordIndexes = (RB_Size**) (ret->coords + size);
+	ret->coordIndexes = tables->coordIndexes;
+	ret->coordLevels = tables->coordLevels;
+	ret->pixelTables = tables;
 	ret->xRange = xRange;
 	ret->yRange = yRange;
-	RB_Size* xyIndexesStart = (RB_Size*) (ret->coordIndexes + xRange);
 
-	for(RB_Size x = 0; x < xRange; x++) {
-		ret->coordIndexes[x] = xyIndexesStart + (x * yRange);
-		for(RB_Size y = 0; y < yRange; y++) {
-			ret->coordIndexes[x][y] = RB_QUEUE_INDEX_UNQUEUED;
-		}
-	} 
+	tables->numQueues++;
 
 	return ret;
 }
 
+// Allocates an assignmentQueue capable of storing the specified number of pixels.
+RB_AssignmentQueue* RB_createAssignmentQueue(RB_Size size, RB_Size xRange, RB_Size yRange) {
+	PixelTables* tables = createPixelTables(xRange, yRange);
+
+	if(tables == NULL) {
+		return NULL;
+	}
+
+	RB_AssignmentQueue* ret = createQueueWithPixelTables(size, xRange, yRange, tables);
+
+	if(ret == NULL) {
+		free(tables);
+	}
+
+	return ret;
+}
+
+RB_AssignmentQueue* RB_createSharedAssignmentQueue(RB_AssignmentQueue* shared, RB_Size size) {
+	return createQueueWithPixelTables(size, shared->xRange, shared->yRange, shared->pixelTables);
+}
+
+// Stops the queue using the shared tile slots, and frees them if no other queue uses them.
+void releaseCoordTileSlots(RB_AssignmentQueue* queue) {
+	if(queue->coordTileSlots == NULL) {
+		return;
+	}
+
+	PixelTables* tables = queue->pixelTables;
+	tables->numTiledQueues--;
+	if(tables->numTiledQueues == 0) {
+		free(tables->coordTileSlots);
+		tables->coordTileSlots = NULL;
+	}
+
+	queue->coordTileSlots = NULL;
+}
+
 // Frees a previously allocated assignmentQueue
 void RB_freeAssignmentQueue(RB_AssignmentQueue* queue) {
+	if(queue == NULL) {
+		return;
+	}
+
 	printf("Freeing RB_AssignmentQueue!\n");
+
+	for(int level = 0; level < RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES; level++) {
+		free(queue->levelPixels[level]);
+		free(queue->levelWeights[level]);
+		free(queue->levelWeightTrees[level]);
+	}
+
+	free(queue->tileCoords);
+	free(queue->tileLens);
+	releaseCoordTileSlots(queue);
+
+	queue->pixelTables->numQueues--;
+	if(queue->pixelTables->numQueues == 0) {
+		free(queue->pixelTables);
+	}
+
 	free(queue);
 }
 
@@ -69,15 +217,157 @@ RB_Size RB_getQueueCapacity(RB_AssignmentQueue* queue) {
 	return queue->maxCoordLen;
 }
 
-// Chooses (using an implementation-specific method) a coord from the queue and returns it.
+// Adds delta to the weight of the level's slot in its Fenwick tree. Negative deltas wrap around, which is fine because
+// the sums they end up in are never negative.
+void addToLevelWeightTree(RB_AssignmentQueue* queue, int level, RB_Size slot, int64_t delta) {
+	uint64_t* tree = queue->levelWeightTrees[level];
+
+	for(RB_Size i = slot + 1; i <= queue->levelCapacities[level]; i += i & -i) {
+		tree[i] += (uint64_t) delta;
+	}
+}
+
+// Fills the level's Fenwick tree from its slot weights in O(capacity) time. Unused slots weigh nothing.
+void buildLevelWeightTree(RB_AssignmentQueue* queue, int level) {
+	uint64_t* tree = queue->levelWeightTrees[level];
+	RB_Size capacity = queue->levelCapacities[level];
+
+	tree[0] = 0;
+	for(RB_Size i = 1; i <= capacity; i++) {
+		tree[i] = (i <= queue->levelLens[level])? queue->levelWeights[level][i - 1] : 0;
+	}
+
+	for(RB_Size i = 1; i <= capacity; i++) {
+		RB_Size parent = i + (i & -i);
+		if(parent <= capacity) {
+			tree[parent] += tree[i];
+		}
+	}
+}
+
+uint64_t getLevelTotalWeight(RB_AssignmentQueue* queue, int level) {
+	uint64_t total = 0;
+
+	for(RB_Size i = queue->levelCapacities[level]; i > 0; i -= i & -i) {
+		total += queue->levelWeightTrees[level][i];
+	}
+
+	return total;
+}
+
+// Returns the slot whose share of the level's cumulative weight contains target, which must be less than the level's
+// total weight. Walks down the Fenwick tree in O(log n) time.
+RB_Size findLevelSlotByWeight(RB_AssignmentQueue* queue, int level, uint64_t target) {
+	uint64_t* tree = queue->levelWeightTrees[level];
+	RB_Size capacity = queue->levelCapacities[level];
+
+	RB_Size step = 1;
+	while(step * 2 <= capacity) {
+		step *= 2;
+	}
+
+	// pos ends up as the number of slots whose weights all fit below the target.
+	RB_Size pos = 0;
+	for(; step > 0; step /= 2) {
+		if(pos + step <= capacity && tree[pos + step] <= target) {
+			pos += step;
+			target -= tree[pos];
+		}
+	}
+
+	return pos;
+}
+
+// A random number below n. rand() alone can be too small for the total weight of a large level.
+uint64_t getRandomWeightBelow(uint64_t n) {
+	uint64_t wide = (((uint64_t) rand()) * ((uint64_t) RAND_MAX + 1)) + (uint64_t) rand();
+	return wide % n;
+}
+
+RB_Size getCoordTile(RB_AssignmentQueue* queue, RB_Coord coord) {
+	return ((coord.x >> RB_QUEUE_TILE_SHIFT) * queue->numTileRows) + (coord.y >> RB_QUEUE_TILE_SHIFT);
+}
+
+uint16_t* getCoordTileSlot(RB_AssignmentQueue* queue, RB_Coord coord) {
+	return queue->coordTileSlots + RB_getPixelIndex(coord, queue->xRange);
+}
+
+// Appends the coord to its tile's array. The coord must not be in it yet.
+void addCoordToTile(RB_AssignmentQueue* queue, RB_Coord coord) {
+	RB_Size tile = getCoordTile(queue, coord);
+	uint16_t offset = ((coord.x & (RB_QUEUE_TILE_SIZE - 1)) << RB_QUEUE_TILE_SHIFT) | (coord.y & (RB_QUEUE_TILE_SIZE - 1));
+
+	queue->tileCoords[(tile * RB_QUEUE_TILE_AREA) + queue->tileLens[tile]] = offset;
+	*getCoordTileSlot(queue, coord) = queue->tileLens[tile];
+	queue->tileLens[tile]++;
+}
+
+RB_Coord getTileCoord(RB_AssignmentQueue* queue, RB_Size tile, RB_Size slot) {
+	uint16_t offset = queue->tileCoords[(tile * RB_QUEUE_TILE_AREA) + slot];
+
+	return (RB_Coord) {
+		.x = ((tile / queue->numTileRows) << RB_QUEUE_TILE_SHIFT) | (offset >> RB_QUEUE_TILE_SHIFT),
+		.y = ((tile % queue->numTileRows) << RB_QUEUE_TILE_SHIFT) | (offset & (RB_QUEUE_TILE_SIZE - 1))
+	};
+}
+
+// Swap-removes the coord from its tile's array. The coord must be in it.
+void removeCoordFromTile(RB_AssignmentQueue* queue, RB_Coord coord) {
+	RB_Size tile = getCoordTile(queue, coord);
+	RB_Size slot = *getCoordTileSlot(queue, coord);
+	RB_Size lastSlot = queue->tileLens[tile] - 1;
+
+	RB_Coord lastCoord = getTileCoord(queue, tile, lastSlot);
+	queue->tileCoords[(tile * RB_QUEUE_TILE_AREA) + slot] = queue->tileCoords[(tile * RB_QUEUE_TILE_AREA) + lastSlot];
+	*getCoordTileSlot(queue, lastCoord) = slot;
+	queue->tileLens[tile]--;
+}
+
+/*
+Usually chooses a random coord from the tile the last coord was chosen from. Once every RB_QUEUE_TILE_LEAVE_ODDS
+choices, or whenever that tile has nothing at the best level left, chooses uniformly from the whole level instead,
+and carries on from that coord's tile.
+*/
+RB_Coord chooseCoordNearLastChoice(RB_AssignmentQueue* queue, int level) {
+	RB_Size tile = queue->lastTile;
+
+	if(tile != RB_QUEUE_TILE_NONE && queue->tileLens[tile] > 0 && rand() % RB_QUEUE_TILE_LEAVE_ODDS != 0) {
+		RB_Coord coord = getTileCoord(queue, tile, ((RB_Size) rand()) % queue->tileLens[tile]);
+
+		// The tile's array holds coords of every level, so a coord of a worse level means leaving the tile.
+		if(queue->coordLevels[RB_getPixelIndex(coord, queue->xRange)] == level) {
+			return coord;
+		}
+	}
+
+	RB_Coord coord = RB_getPixelIndexCoord(
+		queue->levelPixels[level][((RB_Size) rand()) % queue->levelLens[level]], queue->xRange
+	);
+	queue->lastTile = getCoordTile(queue, coord);
+	return coord;
+}
+
+// Chooses a random coord from the best non-empty priority level and returns it.
 RB_Coord RB_chooseCoordFromAssignmentQueue(RB_AssignmentQueue* queue) {
 	if(RB_isQueueEmpty(queue)) {
 		fprintf(stderr, "AssignmentQueue is empty!!\n");
 		return (RB_Coord) { .x = -1, .y = -1 };
 	}
 
-	RB_Size retIndex = ((RB_Size) rand()) % queue->coordLen;
-	return queue->coords[retIndex];
+	int level = __builtin_ctzll(queue->nonEmptyLevels);
+	RB_Size retIndex;
+
+	if(queue->sampling == RB_QUEUE_SAMPLING_TILED) {
+		return chooseCoordNearLastChoice(queue, level);
+	}
+
+	if(queue->sampling == RB_QUEUE_SAMPLING_WEIGHTED) {
+		retIndex = findLevelSlotByWeight(queue, level, getRandomWeightBelow(getLevelTotalWeight(queue, level)));
+	} else {
+		retIndex = ((RB_Size) rand()) % queue->levelLens[level];
+	}
+
+	return RB_getPixelIndexCoord(queue->levelPixels[level][retIndex], queue->xRange);
 }
 
 bool RB_coordIsWithinQueueBounds(RB_AssignmentQueue* queue, RB_Coord coord) {
@@ -89,56 +379,308 @@ bool RB_coordIsWithinQueueBounds(RB_AssignmentQueue* queue, RB_Coord coord) {
 	);
 }
 
+// Returns true if the pixel's index points back at one of this queue's slots.
+bool pixelIsInQueue(RB_AssignmentQueue* queue, RB_PixelIndex pixel) {
+	int32_t index = queue->coordIndexes[pixel];
+
+	if(index == RB_QUEUE_INDEX_UNQUEUED) {
+		return false;
+	}
+
+	int level = queue->coordLevels[pixel];
+	return index < queue->levelLens[level] && queue->levelPixels[level][index] == pixel;
+}
+
 bool RB_coordIsInQueue(RB_AssignmentQueue* queue, RB_Coord coord) {
 	return (
 		RB_coordIsWithinQueueBounds(queue, coord)
-		&& queue->coordIndexes[coord.x][coord.y] != -1
+		&& pixelIsInQueue(queue, RB_getPixelIndex(coord, queue->xRange))
 	);
 }
 
-// If the coord is in the Queue, removes it.
-void RB_removeCoordFromAssignmentQueue(RB_AssignmentQueue* queue, RB_Coord coord) {
-	if(RB_coordIsInQueue(queue, coord)) { // If the coord is in the queue, the queue is guaranteed not to be empty
-		RB_Size coordIndex = queue->coordIndexes[coord.x][coord.y];
+// Takes the pixel out of its level. The pixel must be queued.
+void removePixelFromLevel(RB_AssignmentQueue* queue, RB_PixelIndex pixel) {
+	int level = queue->coordLevels[pixel];
+	RB_Size coordIndex = queue->coordIndexes[pixel];
+
+	RB_Size lastIndex = queue->levelLens[level] - 1;
+	RB_PixelIndex lastPixel = queue->levelPixels[level][lastIndex];
+	uint32_t weight = queue->levelWeights[level][coordIndex];
+	uint32_t lastWeight = queue->levelWeights[level][lastIndex];
+
+	queue->levelPixels[level][coordIndex] = lastPixel;
+	queue->levelWeights[level][coordIndex] = lastWeight;
+	queue->coordIndexes[lastPixel] = coordIndex;
+
+	if(queue->levelWeightTrees[level] != NULL) {
+		addToLevelWeightTree(queue, level, coordIndex, (int64_t) lastWeight - (int64_t) weight);
+		addToLevelWeightTree(queue, level, lastIndex, -((int64_t) lastWeight));
+	}
+
+	queue->coordIndexes[pixel] = RB_QUEUE_INDEX_UNQUEUED;
+
+	queue->levelLens[level]--;
+	if(queue->levelLens[level] == 0) {
+		queue->nonEmptyLevels &= ~(((uint64_t) 1) << level);
+	}
+}
+
+// Puts the pixel at the end of the level with the specified weight, growing the level if it needs to. Returns false if
+// it couldn't grow.
+bool addPixelToLevel(RB_AssignmentQueue* queue, RB_PixelIndex pixel, int level, uint32_t weight) {
+	if(queue->levelLens[level] == queue->levelCapacities[level]) {
+		RB_Size newCapacity = (queue->levelCapacities[level] == 0)?
+			RB_QUEUE_INITIAL_LEVEL_CAPACITY : queue->levelCapacities[level] * 2;
+		if(newCapacity > queue->maxCoordLen) {
+			newCapacity = queue->maxCoordLen;
+		}
+
+		RB_PixelIndex* newPixels = (RB_PixelIndex*) realloc(queue->levelPixels[level], sizeof(RB_PixelIndex) * newCapacity);
+
+		if(newPixels == NULL) {
+			return false;
+		}
+
+		queue->levelPixels[level] = newPixels;
+
+		uint32_t* newWeights = (uint32_t*) realloc(queue->levelWeights[level], sizeof(uint32_t) * newCapacity);
+
+		if(newWeights == NULL) {
+			return false;
+		}
+
+		queue->levelWeights[level] = newWeights;
+
+		if(queue->sampling == RB_QUEUE_SAMPLING_WEIGHTED) {
+			uint64_t* newTree = (uint64_t*) realloc(queue->levelWeightTrees[level], sizeof(uint64_t) * (newCapacity + 1));
+
+			if(newTree == NULL) {
+				return false;
+			}
+
+			queue->levelWeightTrees[level] = newTree;
+		}
+
+		queue->levelCapacities[level] = newCapacity;
+
+		// The tree's shape depends on its length, so it's rebuilt rather than extended. Doubling keeps this O(1)
+		// amortized per add.
+		if(queue->levelWeightTrees[level] != NULL) {
+			buildLevelWeightTree(queue, level);
+		}
+	}
+
+	queue->levelWeights[level][queue->levelLens[level]] = weight;
+	if(queue->levelWeightTrees[level] != NULL) {
+		addToLevelWeightTree(queue, level, queue->levelLens[level], weight);
+	}
 
-		RB_Size lastIndex = queue->coordLen - 1;
-		RB_Coord lastCoord = queue->coords[lastIndex];
+	queue->levelPixels[level][queue->levelLens[level]] = pixel;
+	queue->coordIndexes[pixel] = queue->levelLens[level];
+	queue->coordLevels[pixel] = level;
+	queue->levelLens[level]++;
+	queue->nonEmptyLevels |= ((uint64_t) 1) << level;
 
-		queue->coords[coordIndex] = lastCoord;
-		queue->coordIndexes[lastCoord.x][lastCoord.y] = coordIndex;
+	return true;
+}
+
+// The level that coords with the specified priorityIndex are stored in.
+int getPriorityLevel(RB_Size priorityIndex) {
+	if(priorityIndex < 0 || priorityIndex >= RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES) {
+		return RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES - 1;
+	}
 
-		queue->coordIndexes[coord.x][coord.y] = RB_QUEUE_INDEX_UNQUEUED;
+	return priorityIndex;
+}
 
+// If the coord is in the Queue, removes it.
+void RB_removeCoordFromAssignmentQueue(RB_AssignmentQueue* queue, RB_Coord coord) {
+	if(RB_coordIsInQueue(queue, coord)) { // If the coord is in the queue, the queue is guaranteed not to be empty
+		removePixelFromLevel(queue, RB_getPixelIndex(coord, queue->xRange));
+		if(queue->sampling == RB_QUEUE_SAMPLING_TILED) {
+			removeCoordFromTile(queue, coord);
+		}
 		queue->coordLen--;
 	} else {
-		fprintf(stderr, "Error removing coord from queue: Coord(%d, %d) is not in queue.\n", coord.x, coord.y);
+		fprintf(stderr, "Error removing coord from queue: Coord(%ld, %ld) is not in queue.\n", (long) coord.x, (long) coord.y);
 	}
 }
 
 /*
-- If the pixel is not already queued or assigned, adds the pixel to the queue (with the specified priority, if
-the RB_AssignmentQueue implementation supports prioritization).
-- If the pixel is already queued and the RB_AssignmentQueue implementation supports prioritization, this function may update
-the pixel's priority, though that is not guaranteed.
+- If the pixel is not already queued or assigned, adds the pixel to the queue with the specified priority.
+- If the pixel is already queued, moves it to the specified priority.
 
 Higher positive values for priorityIndex correspond to lower prioritization. A priorityIndex of 0 corresponds to the maximum
 possible prioritization.
-Negative values for priorityIndex correspond to the lowest possible prioritization.
+Negative values for priorityIndex, and values of RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES or more, correspond to the lowest
+possible prioritization.
 */
 void RB_addCoordToAssignmentQueue(RB_AssignmentQueue* queue, RB_Coord toAdd, RB_Size priorityIndex) {
+	if(!RB_coordIsWithinQueueBounds(queue, toAdd)) {
+		fprintf(stderr, "Error adding coord to queue: Coord(%ld, %ld) is out of Bounds(%ld, %ld)!\n",
+			(long) toAdd.x, (long) toAdd.y, (long) queue->xRange, (long) queue->yRange
+		);
+		return;
+	}
+
+	int level = getPriorityLevel(priorityIndex);
+	RB_PixelIndex pixel = RB_getPixelIndex(toAdd, queue->xRange);
+
+	if(pixelIsInQueue(queue, pixel)) {
+		if(queue->coordLevels[pixel] != level) {
+			// The coord's old level always has room to take it back, so this can't fail halfway.
+			int oldLevel = queue->coordLevels[pixel];
+			uint32_t weight = queue->levelWeights[oldLevel][queue->coordIndexes[pixel]];
+			removePixelFromLevel(queue, pixel);
+			if(!addPixelToLevel(queue, pixel, level, weight)) {
+				fprintf(stderr, "Error changing coord's priority: could not grow priority level %d!\n", level);
+				addPixelToLevel(queue, pixel, oldLevel, weight);
+			}
+		}
+		return;
+	}
+
 	if(RB_isQueueFull(queue)) {
 		fprintf(stderr, "Error adding coord to queue: Queue is full!\n");
 		return;
 	}
 
-	if(RB_coordIsWithinQueueBounds(queue, toAdd)) {
-		if(RB_coordIsInQueue(queue, toAdd)) return;
-		queue->coords[queue->coordLen] = toAdd;
-		queue->coordIndexes[toAdd.x][toAdd.y] = queue->coordLen;
-		queue->coordLen++;
-	} else {
-		fprintf(stderr, "Error adding coord to queue: Coord(%d, %d) is out of Bounds(%d, %d)!\n",
-			toAdd.x, toAdd.y, queue->xRange, queue->yRange
-		);
+	if(!addPixelToLevel(queue, pixel, level, RB_ASSIGNMENT_QUEUE_DEFAULT_WEIGHT)) {
+		fprintf(stderr, "Error adding coord to queue: could not grow priority level %d!\n", level);
+		return;
 	}
-}
\ No newline at end of file
+
+	if(queue->sampling == RB_QUEUE_SAMPLING_TILED) {
+		addCoordToTile(queue, toAdd);
+	}
+
+	queue->coordLen++;
+}
+
+void freeLevelWeightTrees(RB_AssignmentQueue* queue) {
+	for(int level = 0; level < RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES; level++) {
+		free(queue->levelWeightTrees[level]);
+		queue->levelWeightTrees[level] = NULL;
+	}
+}
+
+// Builds a weight tree for every level that has been used. Returns false if they couldn't all be allocated.
+bool buildLevelWeightTrees(RB_AssignmentQueue* queue) {
+	for(int level = 0; level < RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES; level++) {
+		if(queue->levelCapacities[level] == 0) {
+			continue;
+		}
+
+		queue->levelWeightTrees[level] = (uint64_t*) malloc(sizeof(uint64_t) * (queue->levelCapacities[level] + 1));
+
+		if(queue->levelWeightTrees[level] == NULL) {
+			freeLevelWeightTrees(queue);
+			return false;
+		}
+
+		buildLevelWeightTree(queue, level);
+	}
+
+	return true;
+}
+
+void freeTiles(RB_AssignmentQueue* queue) {
+	free(queue->tileCoords);
+	free(queue->tileLens);
+	releaseCoordTileSlots(queue);
+	queue->tileCoords = NULL;
+	queue->tileLens = NULL;
+	queue->lastTile = RB_QUEUE_TILE_NONE;
+}
+
+// Allocates the tiles and puts every queued coord in its tile. Returns false if they couldn't be allocated.
+bool buildTiles(RB_AssignmentQueue* queue) {
+	RB_Size numTiles = ((queue->xRange + RB_QUEUE_TILE_SIZE - 1) >> RB_QUEUE_TILE_SHIFT) * queue->numTileRows;
+	PixelTables* tables = queue->pixelTables;
+
+	if(tables->coordTileSlots == NULL) {
+		tables->coordTileSlots = (uint16_t*) malloc(sizeof(uint16_t) * queue->xRange * queue->yRange);
+	}
+
+	if(tables->coordTileSlots != NULL) {
+		queue->coordTileSlots = tables->coordTileSlots;
+		tables->numTiledQueues++;
+	}
+
+	queue->tileCoords = (uint16_t*) malloc(sizeof(uint16_t) * numTiles * RB_QUEUE_TILE_AREA);
+	queue->tileLens = (RB_Size*) calloc(numTiles, sizeof(RB_Size));
+
+	if(queue->tileCoords == NULL || queue->tileLens == NULL || queue->coordTileSlots == NULL) {
+		freeTiles(queue);
+		return false;
+	}
+
+	for(int level = 0; level < RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES; level++) {
+		for(RB_Size i = 0; i < queue->levelLens[level]; i++) {
+			addCoordToTile(queue, RB_getPixelIndexCoord(queue->levelPixels[level][i], queue->xRange));
+		}
+	}
+
+	return true;
+}
+
+bool RB_setAssignmentQueueSampling(RB_AssignmentQueue* queue, RB_QueueSampling sampling) {
+	if(sampling == queue->sampling) {
+		return true;
+	}
+
+	// Build the new mode's structures before freeing the old mode's, so a failure leaves the queue as it was.
+	bool built = true;
+	if(sampling == RB_QUEUE_SAMPLING_WEIGHTED) {
+		built = buildLevelWeightTrees(queue);
+	} else if(sampling == RB_QUEUE_SAMPLING_TILED) {
+		built = buildTiles(queue);
+	}
+
+	if(!built) {
+		fprintf(stderr, "Error setting queue sampling: could not allocate the sampling structures!\n");
+		return false;
+	}
+
+	if(queue->sampling == RB_QUEUE_SAMPLING_WEIGHTED) {
+		freeLevelWeightTrees(queue);
+	} else if(queue->sampling == RB_QUEUE_SAMPLING_TILED) {
+		freeTiles(queue);
+	}
+
+	queue->sampling = sampling;
+	return true;
+}
+
+RB_QueueSampling RB_getAssignmentQueueSampling(RB_AssignmentQueue* queue) {
+	return queue->sampling;
+}
+
+// Sets the weight of a queued coord. Weights are kept in both sampling modes, so they still apply after switching.
+void RB_setCoordWeightInAssignmentQueue(RB_AssignmentQueue* queue, RB_Coord coord, uint32_t weight) {
+	if(!RB_coordIsInQueue(queue, coord)) {
+		fprintf(stderr, "Error setting coord weight: Coord(%ld, %ld) is not in queue.\n", (long) coord.x, (long) coord.y);
+		return;
+	}
+
+	if(weight == 0) {
+		fprintf(stderr, "Error setting coord weight: weights must be at least 1!\n");
+		return;
+	}
+
+	RB_PixelIndex pixel = RB_getPixelIndex(coord, queue->xRange);
+	int level = queue->coordLevels[pixel];
+	RB_Size index = queue->coordIndexes[pixel];
+
+	if(queue->levelWeightTrees[level] != NULL) {
+		addToLevelWeightTree(queue, level, index, (int64_t) weight - (int64_t) queue->levelWeights[level][index]);
+	}
+
+	queue->levelWeights[level][index] = weight;
+}
+
+// Coords are chosen at random, wherever the seeds are.
+void RB_markSeedInAssignmentQueue(RB_AssignmentQueue* queue, RB_Coord coord) {
+	(void) queue;
+	(void) coord;
+}
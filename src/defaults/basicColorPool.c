@@ -2,9 +2,17 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 typedef enum {
+	// A single color. Colors aren't part of the tree (blocks are its leaves), but searches that need to handle colors
+	// one at a time put them in the node queue like any other node.
 	POOL_NODE_COLOR,
+	POOL_NODE_BLOCK,
 	POOL_NODE_OCTANT,
 	POOL_NODE_EMPTY
 } ColorPoolNodeType;
@@ -13,13 +21,24 @@ typedef uint_fast8_t NodeChildrenSize;
 // length = 2^(dimensions_per_color)
 #define RB_COLOR_POOL_NODE_NUM_CHILDREN 8
 
+// The side length, in colors, of a leaf block. Must be a power of two, and a block must have at most 64 colors.
+#define RB_COLOR_POOL_BLOCK_SIZE 4
+#define RB_COLOR_POOL_BLOCK_SHIFT 2
+#define RB_COLOR_POOL_BLOCK_NUM_COLORS 64
+// Blocks with at most this many available colors are searched one color at a time instead of all 64 at once.
+#define RB_COLOR_POOL_BLOCK_SCALAR_THRESHOLD 8
+// The number of block positions in the whole color cube.
+#define RB_COLOR_POOL_NUM_BLOCK_CODES (RB_MAXIMUM_POSSIBLE_NUMBER_OF_COLORS / RB_COLOR_POOL_BLOCK_NUM_COLORS)
+
 typedef struct ColorPoolOctant_s ColorPoolOctant;
+typedef struct ColorPoolBlock_s ColorPoolBlock;
 typedef struct ColorPoolColorNode_s ColorPoolColorNode;
 
 typedef struct ColorPoolNode_s {
 	ColorPoolNodeType type;
 	union {
 		ColorPoolColorNode* colorNodePtr;
+		ColorPoolBlock* blockNodePtr;
 		ColorPoolOctant* octantNodePtr;
 	};
 } ColorPoolNode;
@@ -38,11 +57,44 @@ typedef struct {
 
 struct ColorPoolColorNode_s {
 	RB_Color color;
-	bool isAvailable;
+	// The number of times this color can still be used. The color's bit in its block's availableMask is cleared once
+	// this reaches 0.
+	RB_ColorCount remaining;
+};
+
+/*
+The leaves of the tree. A block holds the pool's colors in one aligned 4x4x4 cube of the color cube, replacing the
+bottom two levels of what would otherwise be octants and individual color nodes. Bit ((r << 4) | (g << 2) | b) of a
+mask stands for the color at (origin + (r, g, b)), and the block's colors are stored contiguously in that order,
+skipping colors that aren't part of the pool.
+*/
+struct ColorPoolBlock_s {
+	// The bounds of the block's available colors, like an octant's.
+	RB_Color minCorner;
+	RB_Color maxCorner;
 
 	ChildNodeParentData parentData;
+
+	RB_Color origin;
+
+	// The colors that are part of the pool.
+	uint64_t presentMask;
+	// The colors that still have remaining uses.
+	uint64_t availableMask;
+
+	// The block's first color. The color for bit i is at colors[popcount(presentMask & ((1 << i) - 1))].
+	ColorPoolColorNode* colors;
+
+	// The total number of remaining uses of the block's colors.
+	RB_Size numAvailable;
 };
 
+// A block's closest available colors to the color being searched for, as found by findClosestInBlock.
+typedef struct {
+	uint64_t tieMask;
+	RB_ColorSquareDistance distance;
+} BlockClosest;
+
 struct ColorPoolOctant_s {
 	// It is guaranteed that if a color's R, G, and B values are between those of minCorner and maxCorner,
 	// that color will either be contained in this octant/this octant's descendants or it will not be contained
@@ -52,8 +104,19 @@ struct ColorPoolOctant_s {
 
 	ChildNodeParentData parentData;
 
+	// Some color that is still available in this octant. Because it's an actual color rather than a corner of the
+	// bounds, the distance to it is a much tighter guaranteed worst case than getBlindWorstDistance.
+	ColorPoolColorNode* representative;
+
+	// The total number of remaining uses of the colors in this octant and its descendants.
+	RB_Size numAvailable;
+
 	ColorPoolNode children[RB_COLOR_POOL_NODE_NUM_CHILDREN];
 	NodeChildrenSize numChildren;
+
+	// The number of times a tree search has looked through this octant's children, while the pool counts expansions.
+	// Only read by RB_exportColorPoolTree, to show where searches spend their time.
+	uint32_t numExpansions;
 };
 
 typedef struct {
@@ -67,21 +130,99 @@ typedef struct {
 	void* dataStart;
 } OctantLayerMetaData;
 
+// The side length, in colors, of the cells used by the octant-sphere engine. Each cell is one of the pool's blocks.
+#define RB_OCTANT_SPHERE_CELL_SIZE RB_COLOR_POOL_BLOCK_SIZE
+#define RB_OCTANT_SPHERE_CELL_SHIFT RB_COLOR_POOL_BLOCK_SHIFT
+
+// A cell offset in the first octant of the sphere. The other seven octants are reached by flipping signs.
+typedef struct {
+	uint8_t dR;
+	uint8_t dG;
+	uint8_t dB;
+} OctantSphereOffset;
+
+// All of the cell offsets whose closest possible color is exactly lowerBound away from the desired color's cell.
+typedef struct {
+	RB_ColorSquareDistance lowerBound;
+	RB_Size firstOffset;
+	RB_Size numOffsets;
+} OctantSphereShell;
+
+typedef struct {
+	// The number of cells along each channel. Signed, like the cell indexes they bound.
+	RB_Size rCells;
+	RB_Size gCells;
+	RB_Size bCells;
+
+	// Shells sorted by increasing lowerBound.
+	OctantSphereShell* shells;
+	RB_Size numShells;
+	OctantSphereOffset* offsets;
+} OctantSphere;
+
+// Big enough to hold the old value of any field that RB_removeColorFromPool writes to.
+typedef union {
+	ColorPoolNode node;
+	ChildNodeParentData parentData;
+	ColorPoolColorNode* colorNodePtr;
+	RB_Color color;
+	RB_Size size;
+	uint64_t mask;
+	RB_ColorCount count;
+	NodeChildrenSize numChildren;
+} PoolJournalValue;
+
+// Records that `size` bytes at `address` held `oldValue` before they were written to.
+typedef struct {
+	void* address;
+	size_t size;
+	PoolJournalValue oldValue;
+} PoolJournalEntry;
+
 struct RB_ColorPool_s {
 	ColorPoolNode root;
 
+	// Stored block by block, in the order of the blocks array.
 	ColorPoolColorNode* colorNodes;
+	RB_Size numColorNodes;
+	ColorPoolBlock* blocks;
+	RB_Size numBlocks;
 	ColorPoolOctant* octants;
+	RB_Size numOctants;
+
+	// Maps the morton code of each block's position (see getBlockMortonCode) to (the index of the block + 1), or 0
+	// if none of the block's colors are part of the pool. Has RB_COLOR_POOL_NUM_BLOCK_CODES entries.
+	// NULL for dense pools, whose blocks are stored in row-major order of their positions.
+	uint32_t* blockLookup;
 
 	ColorPoolNode* nodeQueue;
+	// Indexed like blocks. findIdealAvailableColorInTree keeps the closest colors it found in each block it queued here,
+	// so they don't have to be found again. Only the entries of blocks queued by the current search mean anything.
+	BlockClosest* blockClosest;
 
 	RB_ColorChannelSize rSize;
 	RB_ColorChannelSize gSize;
 	RB_ColorChannelSize bSize;
+
+	RB_ColorPoolSearchEngine engine;
+	// NULL unless the octant-sphere engine has been selected at some point.
+	OctantSphere* sphere;
+
+	// Whether tree searches count their expansions in each octant's numExpansions. Off unless the tree is being
+	// exported, so searches don't write to the octants they only read.
+	bool countsExpansions;
+
+	// The undo journal. Mutations are only recorded between RB_poolMark and RB_poolCommit.
+	bool isJournaling;
+	PoolJournalEntry* journal;
+	RB_Size journalSize;
+	RB_Size journalCapacity;
 };
 
 void printEntireTree(FILE* stream, ColorPoolNode node);
 void printNode(FILE* stream, ColorPoolNode node);
+void freeOctantSphere(OctantSphere* sphere);
+RB_ColorSquareDistance getSquareDistance(RB_Color a, RB_Color b);
 
 
 void updateNodeParentData(ColorPoolNode node, ColorPoolOctant* newParent, NodeChildrenSize newIndex) {
@@ -90,7 +231,10 @@ void updateNodeParentData(ColorPoolNode node, ColorPoolOctant* newParent, NodeCh
 			fprintf(stderr, "Error: attempting to update parent data of an empty node!\n");
 			return;
 		case POOL_NODE_COLOR:
-			node.colorNodePtr->parentData = (ChildNodeParentData) {
+			fprintf(stderr, "Error: attempting to update parent data of a color node! Colors aren't part of the tree.\n");
+			return;
+		case POOL_NODE_BLOCK:
+			node.blockNodePtr->parentData = (ChildNodeParentData) {
 				.octant = newParent,
 				.index = newIndex
 			};
@@ -108,6 +252,8 @@ RB_Color getNodeMinCorner(ColorPoolNode node) {
 	switch(node.type) {
 		case POOL_NODE_OCTANT:
 			return node.octantNodePtr->minCorner;
+		case POOL_NODE_BLOCK:
+			return node.blockNodePtr->minCorner;
 		case POOL_NODE_COLOR:
 			return node.colorNodePtr->color;
 		case POOL_NODE_EMPTY:
@@ -124,6 +270,8 @@ RB_Color getNodeMaxCorner(ColorPoolNode node) {
 	switch(node.type) {
 		case POOL_NODE_OCTANT:
 			return node.octantNodePtr->maxCorner;
+		case POOL_NODE_BLOCK:
+			return node.blockNodePtr->maxCorner;
 		case POOL_NODE_COLOR:
 			return node.colorNodePtr->color;
 		case POOL_NODE_EMPTY:
@@ -176,6 +324,144 @@ RB_Color calculateOctantMaxCorner(ColorPoolOctant* octant) {
 	return ret;
 }
 
+// The local position of a color within its block, which is also its bit in the block's masks.
+int getBlockBitIndex(RB_Color color) {
+	RB_ColorChannel mask = RB_COLOR_POOL_BLOCK_SIZE - 1;
+	return ((color.r & mask) << (2 * RB_COLOR_POOL_BLOCK_SHIFT)) | ((color.g & mask) << RB_COLOR_POOL_BLOCK_SHIFT) | (color.b & mask);
+}
+
+RB_Color getBlockBitColor(ColorPoolBlock* block, int bit) {
+	RB_ColorChannel mask = RB_COLOR_POOL_BLOCK_SIZE - 1;
+	return (RB_Color) {
+		.r = block->origin.r + ((bit >> (2 * RB_COLOR_POOL_BLOCK_SHIFT)) & mask),
+		.g = block->origin.g + ((bit >> RB_COLOR_POOL_BLOCK_SHIFT) & mask),
+		.b = block->origin.b + (bit & mask)
+	};
+}
+
+// The color node for the block's bit. The bit must be set in the block's presentMask.
+ColorPoolColorNode* getBlockColorNode(ColorPoolBlock* block, int bit) {
+	uint64_t below = (((uint64_t) 1) << bit) - 1;
+	return block->colors + __builtin_popcountll(block->presentMask & below);
+}
+
+// Calculates the bounds of the block's available colors. The block must have at least one.
+void calculateBlockCorners(ColorPoolBlock* block, RB_Color* minCorner, RB_Color* maxCorner) {
+	uint64_t mask = block->availableMask;
+	*minCorner = getBlockBitColor(block, __builtin_ctzll(mask));
+	*maxCorner = *minCorner;
+
+	while(mask != 0) {
+		RB_Color color = getBlockBitColor(block, __builtin_ctzll(mask));
+		mask &= mask - 1;
+
+		if(color.r < minCorner->r) minCorner->r = color.r;
+		if(color.g < minCorner->g) minCorner->g = color.g;
+		if(color.b < minCorner->b) minCorner->b = color.b;
+		if(color.r > maxCorner->r) maxCorner->r = color.r;
+		if(color.g > maxCorner->g) maxCorner->g = color.g;
+		if(color.b > maxCorner->b) maxCorner->b = color.b;
+	}
+}
+
+/*
+Finds the smallest square distance from the desired color to any of the block's available colors, and sets tieMask to
+the available colors at exactly that distance. The block must have at least one available color.
+The distance to each of the 64 positions is the sum of one entry from each of three 4-entry per-channel tables, and
+unavailable positions are pushed to the maximum distance with a mask rather than a branch, so the loops have no
+data-dependent branches and can be vectorized.
+Blocks that are nearly used up are cheaper to check one color at a time.
+*/
+RB_ColorSquareDistance findClosestInBlock(ColorPoolBlock* block, RB_Color desired, uint64_t* tieMask) {
+	if(__builtin_popcountll(block->availableMask) <= RB_COLOR_POOL_BLOCK_SCALAR_THRESHOLD) {
+		RB_ColorSquareDistance best = ~((RB_ColorSquareDistance) 0);
+		uint64_t ties = 0;
+
+		for(uint64_t mask = block->availableMask; mask != 0; mask &= mask - 1) {
+			int bit = __builtin_ctzll(mask);
+			RB_ColorSquareDistance dist = getSquareDistance(desired, getBlockBitColor(block, bit));
+
+			if(dist < best) {
+				best = dist;
+				ties = 0;
+			}
+			if(dist == best) {
+				ties |= ((uint64_t) 1) << bit;
+			}
+		}
+
+		*tieMask = ties;
+		return best;
+	}
+
+	uint32_t rDists[RB_COLOR_POOL_BLOCK_SIZE];
+	uint32_t gDists[RB_COLOR_POOL_BLOCK_SIZE];
+	uint32_t bDists[RB_COLOR_POOL_BLOCK_SIZE];
+
+	for(int i = 0; i < RB_COLOR_POOL_BLOCK_SIZE; i++) {
+		int32_t dR = (int32_t) block->origin.r + i - desired.r;
+		int32_t dG = (int32_t) block->origin.g + i - desired.g;
+		int32_t dB = (int32_t) block->origin.b + i - desired.b;
+		rDists[i] = dR * dR;
+		gDists[i] = dG * dG;
+		bDists[i] = dB * dB;
+	}
+
+	uint32_t dists[RB_COLOR_POOL_BLOCK_NUM_COLORS];
+	uint32_t best = UINT32_MAX;
+
+	for(int i = 0; i < RB_COLOR_POOL_BLOCK_NUM_COLORS; i++) {
+		// All ones if the color isn't available, all zeros if it is.
+		uint32_t unavailable = (uint32_t) (((block->availableMask >> i) & 1) - 1);
+		dists[i] = (rDists[i >> 4] + gDists[(i >> 2) & 3] + bDists[i & 3]) | unavailable;
+		best = (dists[i] < best)? dists[i] : best;
+	}
+
+	uint64_t ties = 0;
+	for(int i = 0; i < RB_COLOR_POOL_BLOCK_NUM_COLORS; i++) {
+		ties |= ((uint64_t) (dists[i] == best)) << i;
+	}
+
+	*tieMask = ties;
+	return best;
+}
+
+// Returns a uniformly random set bit of the mask, which must not be 0.
+int getRandomSetBit(uint64_t mask, RB_Size index) {
+	for(RB_Size i = 0; i < index; i++) {
+		mask &= mask - 1;
+	}
+	return __builtin_ctzll(mask);
+}
+
+ColorPoolColorNode* getNodeRepresentative(ColorPoolNode node) {
+	switch(node.type) {
+		case POOL_NODE_OCTANT:
+			return node.octantNodePtr->representative;
+		case POOL_NODE_BLOCK:
+			return getBlockColorNode(node.blockNodePtr, __builtin_ctzll(node.blockNodePtr->availableMask));
+		case POOL_NODE_COLOR:
+			return node.colorNodePtr;
+		case POOL_NODE_EMPTY:
+		default:
+			fprintf(stderr, "Error: attempting to get the representative of an empty node!\n");
+			return NULL;
+	}
+}
+
+RB_Size getNodeAvailableCount(ColorPoolNode node) {
+	switch(node.type) {
+		case POOL_NODE_OCTANT:
+			return node.octantNodePtr->numAvailable;
+		case POOL_NODE_BLOCK:
+			return node.blockNodePtr->numAvailable;
+		case POOL_NODE_COLOR:
+			return node.colorNodePtr->remaining;
+		case POOL_NODE_EMPTY:
+		default:
+			return 0;
+	}
+}
 
 void pruneNewNodeTree(ColorPoolNode node) {
 	if(node.type == POOL_NODE_OCTANT) {
@@ -237,6 +523,87 @@ RB_Size getDataPosition(
 	return (((r * gSize) + g) * bSize) + b;
 }
 
+// Spreads the bits of a channel out so that there are two zero bits between each of them.
+uint32_t spreadChannelBits(RB_ColorChannel channel) {
+	uint32_t x = channel;
+	x = (x | (x << 8)) & 0x0F00F;
+	x = (x | (x << 4)) & 0xC30C3;
+	x = (x | (x << 2)) & 0x249249;
+	return x;
+}
+
+// The inverse of spreadChannelBits.
+RB_ColorChannel compactChannelBits(uint32_t x) {
+	x &= 0x249249;
+	x = (x | (x >> 2)) & 0xC30C3;
+	x = (x | (x >> 4)) & 0x0F00F;
+	x = (x | (x >> 8)) & 0xFF;
+	return (RB_ColorChannel) x;
+}
+
+// Interleaves the bits of the channels. Colors that share an octant at any level of the tree have morton codes that
+// are equal once shifted right by (3 * level), so sorting by morton code groups every octant's colors together.
+uint32_t getColorMortonCode(RB_ColorChannel r, RB_ColorChannel g, RB_ColorChannel b) {
+	return (spreadChannelBits(r) << 2) | (spreadChannelBits(g) << 1) | spreadChannelBits(b);
+}
+
+RB_Color getMortonCodeColor(uint32_t code) {
+	return (RB_Color) {
+		.r = compactChannelBits(code >> 2),
+		.g = compactChannelBits(code >> 1),
+		.b = compactChannelBits(code)
+	};
+}
+
+// The number of blocks needed to cover a channel of the specified size.
+RB_ColorChannelSize getNumBlocksAlongChannel(RB_ColorChannelSize size) {
+	return (size + RB_COLOR_POOL_BLOCK_SIZE - 1) >> RB_COLOR_POOL_BLOCK_SHIFT;
+}
+
+// The morton code of a block's position. A color's morton code is its block's code followed by 6 more bits.
+uint32_t getBlockMortonCode(RB_ColorChannelSize blockR, RB_ColorChannelSize blockG, RB_ColorChannelSize blockB) {
+	return getColorMortonCode(blockR, blockG, blockB);
+}
+
+// Returns the block at the specified block position, or NULL if none of its colors are part of the pool.
+ColorPoolBlock* findBlock(RB_ColorPool* pool, RB_ColorChannelSize blockR, RB_ColorChannelSize blockG, RB_ColorChannelSize blockB) {
+	RB_ColorChannelSize rBlocks = getNumBlocksAlongChannel(pool->rSize);
+	RB_ColorChannelSize gBlocks = getNumBlocksAlongChannel(pool->gSize);
+	RB_ColorChannelSize bBlocks = getNumBlocksAlongChannel(pool->bSize);
+
+	if(blockR >= rBlocks || blockG >= gBlocks || blockB >= bBlocks) {
+		return NULL;
+	}
+
+	if(pool->blockLookup == NULL) {
+		return pool->blocks + getDataPosition(blockR, blockG, blockB, gBlocks, bBlocks);
+	}
+
+	uint32_t lookup = pool->blockLookup[getBlockMortonCode(blockR, blockG, blockB)];
+	return (lookup == 0)? NULL : pool->blocks + (lookup - 1);
+}
+
+// Returns the color node for the specified color, or NULL if the color isn't part of the pool.
+ColorPoolColorNode* findColorNode(RB_ColorPool* pool, RB_Color color) {
+	ColorPoolBlock* block = findBlock(
+		pool,
+		color.r >> RB_COLOR_POOL_BLOCK_SHIFT,
+		color.g >> RB_COLOR_POOL_BLOCK_SHIFT,
+		color.b >> RB_COLOR_POOL_BLOCK_SHIFT
+	);
+
+	if(block == NULL) {
+		return NULL;
+	}
+
+	int bit = getBlockBitIndex(color);
+	if(((block->presentMask >> bit) & 1) == 0) {
+		return NULL;
+	}
+
+	return getBlockColorNode(block, bit);
+}
+
 ColorPoolNode getDataFromLayer(
 	OctantLayerMetaData layerDat,
 	RB_ColorChannelSize layerR,
@@ -250,11 +617,11 @@ ColorPoolNode getDataFromLayer(
 	RB_Size dataPosition = getDataPosition(layerR, layerG, layerB, layerDat.gSize, layerDat.bSize);
 
 	if(layerDat.index == 0) {
-		// This means its the color layer
-		ColorPoolColorNode* colorNodePtr = ((ColorPoolColorNode*) layerDat.dataStart) + dataPosition;
+		// This means its the block layer
+		ColorPoolBlock* blockPtr = ((ColorPoolBlock*) layerDat.dataStart) + dataPosition;
 		return (ColorPoolNode) {
-			.type = POOL_NODE_COLOR,
-			.colorNodePtr = colorNodePtr
+			.type = POOL_NODE_BLOCK,
+			.blockNodePtr = blockPtr
 		};
 	} else {
 		// This means its an octant layer
@@ -267,6 +634,20 @@ ColorPoolNode getDataFromLayer(
 }
 
 RB_ColorPool* RB_createColorPool(RB_ColorChannelSize rSize, RB_ColorChannelSize gSize, RB_ColorChannelSize bSize) {
+	return RB_createColorPoolWithMultiplicity(rSize, gSize, bSize, 1);
+}
+
+RB_ColorPool* RB_createColorPoolWithMultiplicity(
+	RB_ColorChannelSize rSize,
+	RB_ColorChannelSize gSize,
+	RB_ColorChannelSize bSize,
+	RB_ColorCount multiplicity
+) {
+	if(multiplicity < 1) {
+		fprintf(stderr, "Error creating color pool: multiplicity must be at least 1!\n");
+		return NULL;
+	}
+
 	RB_ColorPool* ret = (RB_ColorPool*) malloc(sizeof(RB_ColorPool));
 	
 	if(ret == NULL) {
@@ -277,8 +658,21 @@ RB_ColorPool* RB_createColorPool(RB_ColorChannelSize rSize, RB_ColorChannelSize
 	ret->gSize = gSize;
 	ret->bSize = bSize;
 	ret->colorNodes = NULL;
+	ret->numColorNodes = rSize * gSize * bSize;
+	ret->blocks = NULL;
+	ret->numBlocks = 0;
 	ret->octants = NULL;
+	ret->numOctants = 0;
+	ret->blockLookup = NULL;
 	ret->nodeQueue = NULL;
+	ret->blockClosest = NULL;
+	ret->engine = RB_COLOR_POOL_ENGINE_OCTANT_TREE;
+	ret->sphere = NULL;
+	ret->countsExpansions = false;
+	ret->isJournaling = false;
+	ret->journal = NULL;
+	ret->journalSize = 0;
+	ret->journalCapacity = 0;
 
 
 	// ALLOCATE THE NODE QUEUE
@@ -299,30 +693,62 @@ RB_ColorPool* RB_createColorPool(RB_ColorChannelSize rSize, RB_ColorChannelSize
 	}
 
 
+	// DEAL WITH BLOCKS
+	RB_ColorChannelSize rBlocks = getNumBlocksAlongChannel(rSize);
+	RB_ColorChannelSize gBlocks = getNumBlocksAlongChannel(gSize);
+	RB_ColorChannelSize bBlocks = getNumBlocksAlongChannel(bSize);
+	ret->numBlocks = (RB_Size) rBlocks * gBlocks * bBlocks;
+	ret->blocks = (ColorPoolBlock*) malloc(sizeof(ColorPoolBlock) * ret->numBlocks);
+	ret->blockClosest = (BlockClosest*) malloc(sizeof(BlockClosest) * ret->numBlocks);
+
+	if(ret->blocks == NULL || ret->blockClosest == NULL) {
+		RB_freeColorPool(ret);
+		return NULL;
+	}
+
 	RB_Size colorIndex = 0;
-	for(RB_ColorChannelSize r = 0; r < rSize; r++) {
-		for(RB_ColorChannelSize g = 0; g < gSize; g++) {
-			for(RB_ColorChannelSize b = 0; b < bSize; b++) {
-				RB_Color col = {
-					.r = (RB_ColorChannel) r,
-					.g = (RB_ColorChannel) g,
-					.b = (RB_ColorChannel) b
+	RB_Size blockIndex = 0;
+	for(RB_ColorChannelSize blockR = 0; blockR < rBlocks; blockR++) {
+		for(RB_ColorChannelSize blockG = 0; blockG < gBlocks; blockG++) {
+			for(RB_ColorChannelSize blockB = 0; blockB < bBlocks; blockB++) {
+				ColorPoolBlock* block = ret->blocks + blockIndex;
+				blockIndex++;
+
+				block->parentData.octant = NULL;
+				block->origin = (RB_Color) {
+					.r = blockR << RB_COLOR_POOL_BLOCK_SHIFT,
+					.g = blockG << RB_COLOR_POOL_BLOCK_SHIFT,
+					.b = blockB << RB_COLOR_POOL_BLOCK_SHIFT
 				};
-				ret->colorNodes[colorIndex] = (ColorPoolColorNode) {
-					.color = col,
-					.isAvailable = true,
-					.parentData = {
-						.octant = NULL
+				block->presentMask = 0;
+				block->colors = ret->colorNodes + colorIndex;
+
+				// Blocks on the far edges of the pool can stick out past it.
+				for(int bit = 0; bit < RB_COLOR_POOL_BLOCK_NUM_COLORS; bit++) {
+					RB_Color col = getBlockBitColor(block, bit);
+
+					if(col.r >= rSize || col.g >= gSize || col.b >= bSize) {
+						continue;
 					}
-				};
-				colorIndex++;
+
+					block->presentMask |= ((uint64_t) 1) << bit;
+					ret->colorNodes[colorIndex] = (ColorPoolColorNode) {
+						.color = col,
+						.remaining = multiplicity
+					};
+					colorIndex++;
+				}
+
+				block->availableMask = block->presentMask;
+				block->numAvailable = (RB_Size) __builtin_popcountll(block->presentMask) * multiplicity;
+				calculateBlockCorners(block, &(block->minCorner), &(block->maxCorner));
 			}
 		}
 	}
 
 
 	// DEAL WITH OCTANTS
-	size_t maxOctants = calculateMaximumOctants(rSize, gSize, bSize);
+	size_t maxOctants = calculateMaximumOctants(rBlocks, gBlocks, bBlocks);
 	ret->octants = (ColorPoolOctant*) malloc(sizeof(ColorPoolOctant) * maxOctants);
 
 	if(ret->octants == NULL) {
@@ -334,11 +760,11 @@ RB_ColorPool* RB_createColorPool(RB_ColorChannelSize rSize, RB_ColorChannelSize
 
 	OctantLayerMetaData lastLayer = {
 		.index = 0,
-		.divisor = 1,
-		.rSize = rSize,
-		.gSize = gSize,
-		.bSize = bSize,
-		.dataStart = ret->colorNodes
+		.divisor = RB_COLOR_POOL_BLOCK_SIZE,
+		.rSize = rBlocks,
+		.gSize = gBlocks,
+		.bSize = bBlocks,
+		.dataStart = ret->blocks
 	};
 
 	do {
@@ -375,6 +801,7 @@ RB_ColorPool* RB_createColorPool(RB_ColorChannelSize rSize, RB_ColorChannelSize
 					newOct->minCorner = globalColor;
 					newOct->maxCorner = newOct->minCorner;
 					newOct->numChildren = 0;
+					newOct->numExpansions = 0;
 
 					// The minimum r, g, and b of this octant translated into the coordinates of the previous layer.
 					// minLLay stands for minimum last layer
@@ -403,6 +830,14 @@ RB_ColorPool* RB_createColorPool(RB_ColorChannelSize rSize, RB_ColorChannelSize
 					// calculate newOct's maximum corner
 					newOct->maxCorner = calculateOctantMaxCorner(newOct);
 
+					// The layer below is already built, so its representatives are already set.
+					newOct->representative = getNodeRepresentative(newOct->children[0]);
+
+					newOct->numAvailable = 0;
+					for(NodeChildrenSize i = 0; i < newOct->numChildren; i++) {
+						newOct->numAvailable += getNodeAvailableCount(newOct->children[i]);
+					}
+
 					// Make sure the rest of the children are empty nodes.
 					// This step arguably isn't necessary, but I'm doing it anyway.
 					for(NodeChildrenSize i = newOct->numChildren; i < RB_COLOR_POOL_NODE_NUM_CHILDREN; i++) {
@@ -415,6 +850,8 @@ RB_ColorPool* RB_createColorPool(RB_ColorChannelSize rSize, RB_ColorChannelSize
 		lastLayer = layer;
 	} while(lastLayer.rSize > 1 || lastLayer.gSize > 1 || lastLayer.bSize > 1);
 
+	ret->numOctants = octantDataIndex;
+
 	// set the root node
 	ret->root = (ColorPoolNode) {
 		.type = POOL_NODE_OCTANT,
@@ -424,285 +861,2055 @@ RB_ColorPool* RB_createColorPool(RB_ColorChannelSize rSize, RB_ColorChannelSize
 	//prune the tree
 	pruneNewNodeTree(ret->root);
 
+	// pruneNewNodeTree can't replace the root, so do that here. A pool that fits in one block ends up with the block
+	// as its root.
+	while(ret->root.type == POOL_NODE_OCTANT && ret->root.octantNodePtr->numChildren == 1) {
+		ret->root = ret->root.octantNodePtr->children[0];
+		updateNodeParentData(ret->root, NULL, 0);
+	}
+
 	return ret;
 }
 
-// Frees a previously allocated color pool
-void RB_freeColorPool(RB_ColorPool* pool) {
-	if(pool == NULL) {
-		return;
+// Where a sparse pool's colors are counted from.
+typedef struct {
+	// If not NULL, the counts are a histogram of morton codes with RB_MAXIMUM_POSSIBLE_NUMBER_OF_COLORS entries.
+	const uint32_t* histogram;
+
+	// Otherwise, the count of each color with rBegin <= r < rEnd, g < gSize and b < bSize is
+	// counts[((r * gSize) + g) * bSize + b], and every other color's count is 0.
+	const RB_ColorCount* counts;
+	RB_ColorChannelSize rBegin;
+	RB_ColorChannelSize rEnd;
+	RB_ColorChannelSize gSize;
+	RB_ColorChannelSize bSize;
+} SparseColorCounts;
+
+/*
+Reads the counts of the colors in the block whose first color has the morton code blockStart into counts, indexed by
+their bits in the block's masks, and returns the mask of the bits whose counts aren't 0. localCodes maps each bit to
+the offset of its color's code from blockStart.
+Blocks that can't have any colors in a ranged source are skipped without reading anything.
+*/
+uint64_t getSparseBlockCounts(
+	const SparseColorCounts* source,
+	uint32_t blockStart,
+	const uint32_t* localCodes,
+	RB_ColorCount* counts
+) {
+	uint64_t presentMask = 0;
+
+	if(source->histogram != NULL) {
+		for(int bit = 0; bit < RB_COLOR_POOL_BLOCK_NUM_COLORS; bit++) {
+			counts[bit] = source->histogram[blockStart + localCodes[bit]];
+			presentMask |= ((uint64_t) (counts[bit] > 0)) << bit;
+		}
+
+		return presentMask;
 	}
 
-	printf("Freeing RB_ColorPool!\n");
+	ColorPoolBlock block = { .origin = getMortonCodeColor(blockStart) };
 
-	free(pool->colorNodes);
-	pool->colorNodes = NULL;
+	if(
+		block.origin.r >= source->rEnd || (RB_ColorChannelSize) block.origin.r + RB_COLOR_POOL_BLOCK_SIZE <= source->rBegin
+		|| block.origin.g >= source->gSize || block.origin.b >= source->bSize
+	) {
+		return 0;
+	}
 
-	free(pool->octants);
-	pool->octants = NULL;
+	for(int bit = 0; bit < RB_COLOR_POOL_BLOCK_NUM_COLORS; bit++) {
+		RB_Color color = getBlockBitColor(&block, bit);
+		counts[bit] = 0;
 
-	free(pool->nodeQueue);
-	pool->nodeQueue = NULL;
+		if(color.r >= source->rBegin && color.r < source->rEnd && color.g < source->gSize && color.b < source->bSize) {
+			counts[bit] = source->counts[getDataPosition(color.r, color.g, color.b, source->gSize, source->bSize)];
+		}
 
-	free(pool);
-}
+		presentMask |= ((uint64_t) (counts[bit] > 0)) << bit;
+	}
 
-RB_ColorChannel getChannelValueWithinBoundaries(RB_ColorChannel minVal, RB_ColorChannel maxVal, RB_ColorChannel toBound) {
-	RB_ColorChannel lowerBounded = toBound < minVal? minVal : toBound;
-	return lowerBounded > maxVal? maxVal : lowerBounded;
+	return presentMask;
 }
 
+/*
+Builds a pool holding only the colors whose counts aren't 0.
+1) Walk the color cube one block at a time, in morton order, creating a block for each block position that has any
+colors and a color node for each of its colors. A color's morton code is its block's code followed by its position
+within the block, so this leaves the blocks sorted by morton code.
+2) Build the tree one level at a time. Consecutive nodes whose codes match after shifting off another 3 bits share a
+parent, so each run of them becomes one new octant. Only occupied octants are ever created.
+*/
+RB_ColorPool* createSparseColorPool(const SparseColorCounts* source) {
+	RB_ColorPool* ret = (RB_ColorPool*) malloc(sizeof(RB_ColorPool));
 
-RB_ColorSquareDistance getSquareDistance(RB_Color a, RB_Color b) {
-	RB_ColorChannelDifference dR = a.r - b.r;
-	RB_ColorChannelDifference dG = a.g - b.g;
-	RB_ColorChannelDifference dB = a.b - b.b;
+	if(ret == NULL) {
+		return NULL;
+	}
 
-	return (
-		((RB_ColorSquareDistance) dR * dR)
-		+ ((RB_ColorSquareDistance) dG * dG)
-		+ ((RB_ColorSquareDistance) dB * dB)
-	);
-}
+	ret->rSize = 0;
+	ret->gSize = 0;
+	ret->bSize = 0;
+	ret->colorNodes = NULL;
+	ret->numColorNodes = 0;
+	ret->blocks = NULL;
+	ret->numBlocks = 0;
+	ret->octants = NULL;
+	ret->numOctants = 0;
+	ret->blockLookup = NULL;
+	ret->nodeQueue = NULL;
+	ret->blockClosest = NULL;
+	ret->engine = RB_COLOR_POOL_ENGINE_OCTANT_TREE;
+	ret->sphere = NULL;
+	ret->countsExpansions = false;
+	ret->isJournaling = false;
+	ret->journal = NULL;
+	ret->journalSize = 0;
+	ret->journalCapacity = 0;
+	ret->root = emptyColorPoolNode;
+
+	// The low 6 bits of a color's morton code are the morton code of its position within its block, so this maps
+	// each of a block's bits to the offset of its color's code from the block's first code.
+	uint32_t localCodes[RB_COLOR_POOL_BLOCK_NUM_COLORS];
+	for(uint32_t localCode = 0; localCode < RB_COLOR_POOL_BLOCK_NUM_COLORS; localCode++) {
+		localCodes[getBlockBitIndex(getMortonCodeColor(localCode))] = localCode;
+	}
 
-// RB_ColorSquareDistance getSquareDistance(RB_Color aRaw, RB_Color bRaw) {
-// 	HSVColor a = rgbToHSV(
-		
-// 	)
+	RB_ColorCount counts[RB_COLOR_POOL_BLOCK_NUM_COLORS];
 
-// 	RB_ColorChannelDifference dR = a.r - b.r;
-// 	RB_ColorChannelDifference dG = a.g - b.g;
-// 	RB_ColorChannelDifference dB = a.b - b.b;
+	for(uint32_t code = 0; code < RB_MAXIMUM_POSSIBLE_NUMBER_OF_COLORS; code += RB_COLOR_POOL_BLOCK_NUM_COLORS) {
+		uint64_t presentMask = getSparseBlockCounts(source, code, localCodes, counts);
 
-// 	return (
-// 		((RB_ColorSquareDistance) dR * dR)
-// 		+ ((RB_ColorSquareDistance) dG * dG)
-// 		+ ((RB_ColorSquareDistance) dB * dB)
-// 	);
-// }
+		if(presentMask != 0) {
+			ret->numColorNodes += __builtin_popcountll(presentMask);
+			ret->numBlocks++;
+		}
+	}
 
-// Using only the bounds of the octant and not the actual elements inside of it, what's the closest color
-// that this octant could possibly contain?
-RB_ColorSquareDistance getBlindClosestDistance(ColorPoolNode node, RB_Color color) {
-	switch(node.type) {
-		case POOL_NODE_EMPTY:
-			fprintf(stderr, "Attemping to get the closest distance to an empty node!\n");
-			return ~((RB_ColorSquareDistance) 0); // This should return the maximum possible value
-		case POOL_NODE_OCTANT: {
-			ColorPoolOctant* octant = node.octantNodePtr;
-			RB_Color closest = (RB_Color) {
-				.r = getChannelValueWithinBoundaries(octant->minCorner.r, octant->maxCorner.r, color.r),
-				.g = getChannelValueWithinBoundaries(octant->minCorner.g, octant->maxCorner.g, color.g),
-				.b = getChannelValueWithinBoundaries(octant->minCorner.b, octant->maxCorner.b, color.b),
-			};
-			return getSquareDistance(color, closest);
+	if(ret->numColorNodes == 0) {
+		fprintf(stderr, "Error creating color pool: there are no colors!\n");
+		RB_freeColorPool(ret);
+		return NULL;
+	}
+
+	ret->colorNodes = (ColorPoolColorNode*) malloc(sizeof(ColorPoolColorNode) * ret->numColorNodes);
+	ret->blocks = (ColorPoolBlock*) malloc(sizeof(ColorPoolBlock) * ret->numBlocks);
+	ret->blockLookup = (uint32_t*) calloc(RB_COLOR_POOL_NUM_BLOCK_CODES, sizeof(uint32_t));
+	ret->nodeQueue = (ColorPoolNode*) malloc(sizeof(ColorPoolNode) * ret->numColorNodes);
+	ret->blockClosest = (BlockClosest*) malloc(sizeof(BlockClosest) * ret->numBlocks);
+	// The morton codes of the current level's nodes, so they can be grouped into the next level.
+	uint32_t* levelCodes = (uint32_t*) malloc(sizeof(uint32_t) * ret->numBlocks);
+	ColorPoolNode* levelNodes = (ColorPoolNode*) malloc(sizeof(ColorPoolNode) * ret->numBlocks);
+
+	if(
+		ret->colorNodes == NULL || ret->blocks == NULL || ret->blockLookup == NULL || ret->nodeQueue == NULL
+		|| ret->blockClosest == NULL || levelCodes == NULL || levelNodes == NULL
+	) {
+		free(levelCodes);
+		free(levelNodes);
+		RB_freeColorPool(ret);
+		return NULL;
+	}
+
+	RB_Size colorIndex = 0;
+	RB_Size blockIndex = 0;
+	for(uint32_t code = 0; code < RB_MAXIMUM_POSSIBLE_NUMBER_OF_COLORS; code += RB_COLOR_POOL_BLOCK_NUM_COLORS) {
+		uint64_t presentMask = getSparseBlockCounts(source, code, localCodes, counts);
+
+		if(presentMask == 0) {
+			continue;
 		}
-		case POOL_NODE_COLOR: {
-			ColorPoolColorNode* colorNodePtr = node.colorNodePtr;
-			return getSquareDistance(color, colorNodePtr->color);
+
+		uint32_t blockCode = code / RB_COLOR_POOL_BLOCK_NUM_COLORS;
+		ColorPoolBlock* block = ret->blocks + blockIndex;
+
+		block->parentData.octant = NULL;
+		block->origin = getMortonCodeColor(code);
+		block->presentMask = presentMask;
+		block->availableMask = presentMask;
+		block->numAvailable = 0;
+		block->colors = ret->colorNodes + colorIndex;
+
+		for(uint64_t mask = block->presentMask; mask != 0; mask &= mask - 1) {
+			int bit = __builtin_ctzll(mask);
+			RB_Color color = getBlockBitColor(block, bit);
+
+			ret->colorNodes[colorIndex] = (ColorPoolColorNode) {
+				.color = color,
+				.remaining = counts[bit]
+			};
+			block->numAvailable += counts[bit];
+			colorIndex++;
+
+			if(color.r >= ret->rSize) ret->rSize = color.r + 1;
+			if(color.g >= ret->gSize) ret->gSize = color.g + 1;
+			if(color.b >= ret->bSize) ret->bSize = color.b + 1;
 		}
+
+		calculateBlockCorners(block, &(block->minCorner), &(block->maxCorner));
+
+		ret->blockLookup[blockCode] = blockIndex + 1;
+		levelCodes[blockIndex] = blockCode;
+		levelNodes[blockIndex] = (ColorPoolNode) {
+			.type = POOL_NODE_BLOCK,
+			.blockNodePtr = block
+		};
+		blockIndex++;
 	}
-}
 
-RB_ColorSquareDistance getBlindWorstDistance(ColorPoolNode node, RB_Color color) {
-	switch(node.type) {
-		case POOL_NODE_EMPTY:
-			fprintf(stderr, "Attemping to get the worst distance to an empty node!\n");
-			return 0;
-		case POOL_NODE_OCTANT: {
-			ColorPoolOctant* octant = node.octantNodePtr;
-			RB_Color furthestColor = {
-				.r = ((color.r * 2) - (octant->minCorner.r + octant->maxCorner.r)) > 0?
-					octant->minCorner.r : octant->maxCorner.r,
-				.g = ((color.g * 2) - (octant->minCorner.g + octant->maxCorner.g)) > 0?
-					octant->minCorner.g : octant->maxCorner.g,
-				.b = ((color.b * 2) - (octant->minCorner.b + octant->maxCorner.b)) > 0?
-					octant->minCorner.b : octant->maxCorner.b
-			};
-			return getSquareDistance(color, furthestColor);
+	// Count the octants on every level so they can all be allocated at once.
+	size_t numOctants = 0;
+	RB_Size numLevelNodes = ret->numBlocks;
+	for(int shift = 3; numLevelNodes > 1; shift += 3) {
+		numLevelNodes = 0;
+		for(RB_Size i = 0; i < ret->numBlocks; i++) {
+			if(i == 0 || (levelCodes[i] >> shift) != (levelCodes[i - 1] >> shift)) {
+				numLevelNodes++;
+			}
 		}
-		case POOL_NODE_COLOR: {
-			ColorPoolColorNode* colorNodePtr = node.colorNodePtr;
-			return getSquareDistance(color, colorNodePtr->color);
+		numOctants += numLevelNodes;
+	}
+
+	if(numOctants > 0) {
+		ret->octants = (ColorPoolOctant*) malloc(sizeof(ColorPoolOctant) * numOctants);
+
+		if(ret->octants == NULL) {
+			free(levelCodes);
+			free(levelNodes);
+			RB_freeColorPool(ret);
+			return NULL;
 		}
 	}
-}
 
+	ret->numOctants = numOctants;
+	RB_Size octantDataIndex = 0;
+	numLevelNodes = ret->numBlocks;
+
+	while(numLevelNodes > 1) {
+		RB_Size numNextLevelNodes = 0;
+
+		for(RB_Size i = 0; i < numLevelNodes; i++) {
+			// Read the node before anything is written over it. The next level is written into the same arrays, but
+			// it never has more nodes than this one, so it never gets ahead of i.
+			ColorPoolNode child = levelNodes[i];
+			uint32_t parentCode = levelCodes[i] >> 3;
+
+			if(numNextLevelNodes == 0 || parentCode != levelCodes[numNextLevelNodes - 1]) {
+				ColorPoolOctant* newOct = ret->octants + octantDataIndex;
+				octantDataIndex++;
+
+				newOct->parentData.octant = NULL;
+				newOct->numChildren = 0;
+				newOct->numAvailable = 0;
+				newOct->numExpansions = 0;
+
+				levelCodes[numNextLevelNodes] = parentCode;
+				levelNodes[numNextLevelNodes] = (ColorPoolNode) {
+					.type = POOL_NODE_OCTANT,
+					.octantNodePtr = newOct
+				};
+				numNextLevelNodes++;
+			}
 
-/*
-Basic algorithm (figured out by me!):
-1) Add the root node to the "node queue." At the start, it will be the only node in the queue.
-2) Initialize minWorstCase to the worst case of the root node, I guess.
+			ColorPoolOctant* parent = levelNodes[numNextLevelNodes - 1].octantNodePtr;
+
+			updateNodeParentData(child, parent, parent->numChildren);
+			parent->children[parent->numChildren] = child;
+			parent->numChildren++;
+			parent->numAvailable += getNodeAvailableCount(child);
+		}
+
+		for(RB_Size i = 0; i < numNextLevelNodes; i++) {
+			ColorPoolOctant* oct = levelNodes[i].octantNodePtr;
+
+			oct->minCorner = calculateOctantMinCorner(oct);
+			oct->maxCorner = calculateOctantMaxCorner(oct);
+			oct->representative = getNodeRepresentative(oct->children[0]);
+
+			for(NodeChildrenSize j = oct->numChildren; j < RB_COLOR_POOL_NODE_NUM_CHILDREN; j++) {
+				oct->children[j] = emptyColorPoolNode;
+			}
+		}
+
+		numLevelNodes = numNextLevelNodes;
+	}
+
+	ret->root = levelNodes[0];
+	free(levelCodes);
+	free(levelNodes);
+
+	pruneNewNodeTree(ret->root);
+
+	// pruneNewNodeTree can't replace the root, so do that here.
+	while(ret->root.type == POOL_NODE_OCTANT && ret->root.octantNodePtr->numChildren == 1) {
+		ret->root = ret->root.octantNodePtr->children[0];
+		updateNodeParentData(ret->root, NULL, 0);
+	}
+
+	return ret;
+}
+
+// Builds a pool from a histogram of morton codes (see getColorMortonCode) with RB_MAXIMUM_POSSIBLE_NUMBER_OF_COLORS
+// entries, then frees the histogram.
+RB_ColorPool* createColorPoolFromHistogram(uint32_t* histogram) {
+	SparseColorCounts source = { .histogram = histogram };
+	RB_ColorPool* ret = createSparseColorPool(&source);
+	free(histogram);
+	return ret;
+}
+
+RB_ColorPool* RB_createColorPoolFromColors(const RB_Color* colors, RB_Size numColors) {
+	uint32_t* histogram = (uint32_t*) calloc(RB_MAXIMUM_POSSIBLE_NUMBER_OF_COLORS, sizeof(uint32_t));
+
+	if(histogram == NULL) {
+		return NULL;
+	}
+
+	for(RB_Size i = 0; i < numColors; i++) {
+		histogram[getColorMortonCode(colors[i].r, colors[i].g, colors[i].b)]++;
+	}
+
+	return createColorPoolFromHistogram(histogram);
+}
+
+// Returns the offset of the pixel data in a binary (P6) PPM file, and sets numPixels to the number of pixels in it.
+// Returns -1 if the header isn't one this can read, or the file is too short to hold every pixel.
+off_t getPPMDataOffset(const unsigned char* data, off_t size, RB_Size* numPixels) {
+	// The header is "P6", then width, height and maxval, each preceded by whitespace and possibly comments, then
+	// exactly one whitespace character.
+	if(size < 2 || data[0] != 'P' || data[1] != '6') {
+		return -1;
+	}
+
+	off_t pos = 2;
+	long values[3];
+
+	for(int i = 0; i < 3; i++) {
+		while(pos < size && (data[pos] == ' ' || data[pos] == '\t' || data[pos] == '\n' || data[pos] == '\r' || data[pos] == '#')) {
+			if(data[pos] == '#') {
+				while(pos < size && data[pos] != '\n') pos++;
+			} else {
+				pos++;
+			}
+		}
+
+		values[i] = 0;
+		if(pos >= size || data[pos] < '0' || data[pos] > '9') {
+			return -1;
+		}
+		while(pos < size && data[pos] >= '0' && data[pos] <= '9') {
+			values[i] = (values[i] * 10) + (data[pos] - '0');
+			pos++;
+
+			// No image this big could be used anyway, and stopping here keeps the product below from overflowing.
+			if(values[i] > RB_MAXIMUM_POSSIBLE_NUMBER_OF_PIXELS) {
+				return -1;
+			}
+		}
+	}
+
+	// Only one byte per channel is supported.
+	if(values[2] < 1 || values[2] >= RB_MAXIMUM_COLOR_CHANNEL_RESOLUTION) {
+		return -1;
+	}
+
+	if(values[0] < 1 || values[1] < 1 || values[0] > RB_MAXIMUM_POSSIBLE_NUMBER_OF_PIXELS / values[1]) {
+		return -1;
+	}
+
+	pos++;
+	if(pos + ((off_t) values[0] * values[1] * 3) > size) {
+		return -1;
+	}
+
+	*numPixels = values[0] * values[1];
+	return pos;
+}
+
+RB_ColorPool* RB_createColorPoolFromFile(const char* path, RB_ColorFileFormat format) {
+	int fd = open(path, O_RDONLY);
+
+	if(fd < 0) {
+		fprintf(stderr, "Error creating color pool: could not open %s!\n", path);
+		return NULL;
+	}
+
+	struct stat fileStat;
+	if(fstat(fd, &fileStat) != 0) {
+		fprintf(stderr, "Error creating color pool: could not read the size of %s!\n", path);
+		close(fd);
+		return NULL;
+	}
+
+	// mmap can't map an empty file.
+	if(fileStat.st_size == 0) {
+		fprintf(stderr, "Error creating color pool: %s is empty!\n", path);
+		close(fd);
+		return NULL;
+	}
+
+	const unsigned char* data = (const unsigned char*) mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if(data == MAP_FAILED) {
+		fprintf(stderr, "Error creating color pool: could not map %s!\n", path);
+		return NULL;
+	}
+
+	madvise((void*) data, fileStat.st_size, MADV_SEQUENTIAL);
+
+	off_t dataOffset = 0;
+	RB_Size numColors = 0;
+
+	if(format == RB_COLOR_FILE_PPM) {
+		dataOffset = getPPMDataOffset(data, fileStat.st_size, &numColors);
+
+		if(dataOffset < 0) {
+			fprintf(stderr, "Error creating color pool: %s is not a PPM file with one byte per channel!\n", path);
+			munmap((void*) data, fileStat.st_size);
+			return NULL;
+		}
+	} else {
+		if(fileStat.st_size % 3 != 0) {
+			fprintf(stderr, "Error creating color pool: %s is not raw RGB, its size isn't a multiple of 3!\n", path);
+			munmap((void*) data, fileStat.st_size);
+			return NULL;
+		}
+
+		numColors = fileStat.st_size / 3;
+	}
+
+	uint32_t* histogram = (uint32_t*) calloc(RB_MAXIMUM_POSSIBLE_NUMBER_OF_COLORS, sizeof(uint32_t));
+
+	if(histogram == NULL) {
+		munmap((void*) data, fileStat.st_size);
+		return NULL;
+	}
+
+	const unsigned char* pixel = data + dataOffset;
+	const unsigned char* end = pixel + (numColors * 3);
+	for(; pixel < end; pixel += 3) {
+		histogram[getColorMortonCode(pixel[0], pixel[1], pixel[2])]++;
+	}
+
+	munmap((void*) data, fileStat.st_size);
+
+	return createColorPoolFromHistogram(histogram);
+}
+
+RB_ColorPool* RB_createColorPoolFromCounts(
+	const RB_ColorCount* counts,
+	RB_ColorChannelSize rBegin,
+	RB_ColorChannelSize rEnd,
+	RB_ColorChannelSize gSize,
+	RB_ColorChannelSize bSize
+) {
+	if(
+		rBegin >= rEnd || rEnd > RB_MAXIMUM_COLOR_CHANNEL_RESOLUTION
+		|| gSize > RB_MAXIMUM_COLOR_CHANNEL_RESOLUTION || bSize > RB_MAXIMUM_COLOR_CHANNEL_RESOLUTION
+	) {
+		fprintf(stderr, "Error creating color pool: the range of colors to count is not valid!\n");
+		return NULL;
+	}
+
+	SparseColorCounts source = {
+		.histogram = NULL,
+		.counts = counts,
+		.rBegin = rBegin,
+		.rEnd = rEnd,
+		.gSize = gSize,
+		.bSize = bSize
+	};
+
+	return createSparseColorPool(&source);
+}
+
+// Frees a previously allocated color pool
+void RB_freeColorPool(RB_ColorPool* pool) {
+	if(pool == NULL) {
+		return;
+	}
+
+	printf("Freeing RB_ColorPool!\n");
+
+	free(pool->colorNodes);
+	pool->colorNodes = NULL;
+
+	free(pool->blocks);
+	pool->blocks = NULL;
+
+	free(pool->octants);
+	pool->octants = NULL;
+
+	free(pool->blockLookup);
+	pool->blockLookup = NULL;
+
+	free(pool->nodeQueue);
+	pool->nodeQueue = NULL;
+
+	free(pool->blockClosest);
+	pool->blockClosest = NULL;
+
+	freeOctantSphere(pool->sphere);
+	pool->sphere = NULL;
+
+	free(pool->journal);
+	pool->journal = NULL;
+
+	free(pool);
+}
+
+// Points a node from the original pool at the same node in the clone. Both pools lay their nodes out identically, so
+// only the base addresses differ.
+ColorPoolNode rebaseNode(ColorPoolNode node, const RB_ColorPool* original, RB_ColorPool* clone) {
+	switch(node.type) {
+		case POOL_NODE_COLOR:
+			node.colorNodePtr = clone->colorNodes + (node.colorNodePtr - original->colorNodes);
+			break;
+		case POOL_NODE_BLOCK:
+			node.blockNodePtr = clone->blocks + (node.blockNodePtr - original->blocks);
+			break;
+		case POOL_NODE_OCTANT:
+			node.octantNodePtr = clone->octants + (node.octantNodePtr - original->octants);
+			break;
+		case POOL_NODE_EMPTY:
+			break;
+	}
+
+	return node;
+}
+
+ColorPoolOctant* rebaseOctant(ColorPoolOctant* octant, const RB_ColorPool* original, RB_ColorPool* clone) {
+	return (octant == NULL)? NULL : clone->octants + (octant - original->octants);
+}
+
+OctantSphere* cloneOctantSphere(const OctantSphere* original) {
+	OctantSphere* ret = (OctantSphere*) malloc(sizeof(OctantSphere));
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	*ret = *original;
+
+	RB_Size offsetsPerChannel = RB_MAXIMUM_COLOR_CHANNEL_RESOLUTION >> RB_OCTANT_SPHERE_CELL_SHIFT;
+	RB_Size numOffsets = offsetsPerChannel * offsetsPerChannel * offsetsPerChannel;
+
+	ret->shells = (OctantSphereShell*) malloc(sizeof(OctantSphereShell) * ret->numShells);
+	ret->offsets = (OctantSphereOffset*) malloc(sizeof(OctantSphereOffset) * numOffsets);
+
+	if(ret->shells == NULL || ret->offsets == NULL) {
+		freeOctantSphere(ret);
+		return NULL;
+	}
+
+	memcpy(ret->shells, original->shells, sizeof(OctantSphereShell) * ret->numShells);
+	memcpy(ret->offsets, original->offsets, sizeof(OctantSphereOffset) * numOffsets);
+
+	return ret;
+}
+
+/*
+Copies the pool's arrays wholesale, then rebases every pointer that points into them. This avoids everything that
+makes building a pool slow (walking the color cube, building each level, pruning), so it's the cheap way to get a fresh
+pool for each of many runs: build one pool, never remove from it, and clone it for every run.
+The clone doesn't inherit the original's undo journal.
+*/
+RB_ColorPool* RB_cloneColorPool(const RB_ColorPool* original) {
+	RB_ColorPool* ret = (RB_ColorPool*) malloc(sizeof(RB_ColorPool));
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	*ret = *original;
+	ret->colorNodes = NULL;
+	ret->blocks = NULL;
+	ret->octants = NULL;
+	ret->blockLookup = NULL;
+	ret->nodeQueue = NULL;
+	ret->blockClosest = NULL;
+	ret->sphere = NULL;
+	ret->isJournaling = false;
+	ret->journal = NULL;
+	ret->journalSize = 0;
+	ret->journalCapacity = 0;
+
+	ret->colorNodes = (ColorPoolColorNode*) malloc(sizeof(ColorPoolColorNode) * original->numColorNodes);
+	ret->blocks = (ColorPoolBlock*) malloc(sizeof(ColorPoolBlock) * original->numBlocks);
+	ret->nodeQueue = (ColorPoolNode*) malloc(sizeof(ColorPoolNode) * original->numColorNodes);
+	ret->blockClosest = (BlockClosest*) malloc(sizeof(BlockClosest) * original->numBlocks);
+
+	if(ret->colorNodes == NULL || ret->blocks == NULL || ret->nodeQueue == NULL || ret->blockClosest == NULL) {
+		RB_freeColorPool(ret);
+		return NULL;
+	}
+
+	memcpy(ret->colorNodes, original->colorNodes, sizeof(ColorPoolColorNode) * original->numColorNodes);
+	memcpy(ret->blocks, original->blocks, sizeof(ColorPoolBlock) * original->numBlocks);
+
+	if(original->numOctants > 0) {
+		ret->octants = (ColorPoolOctant*) malloc(sizeof(ColorPoolOctant) * original->numOctants);
+
+		if(ret->octants == NULL) {
+			RB_freeColorPool(ret);
+			return NULL;
+		}
+
+		memcpy(ret->octants, original->octants, sizeof(ColorPoolOctant) * original->numOctants);
+	}
+
+	if(original->blockLookup != NULL) {
+		ret->blockLookup = (uint32_t*) malloc(sizeof(uint32_t) * RB_COLOR_POOL_NUM_BLOCK_CODES);
+
+		if(ret->blockLookup == NULL) {
+			RB_freeColorPool(ret);
+			return NULL;
+		}
+
+		memcpy(ret->blockLookup, original->blockLookup, sizeof(uint32_t) * RB_COLOR_POOL_NUM_BLOCK_CODES);
+	}
+
+	if(original->sphere != NULL) {
+		ret->sphere = cloneOctantSphere(original->sphere);
+
+		if(ret->sphere == NULL) {
+			RB_freeColorPool(ret);
+			return NULL;
+		}
+	}
+
+	// REBASE THE POINTERS
+	ret->root = rebaseNode(original->root, original, ret);
+
+	for(RB_Size i = 0; i < ret->numBlocks; i++) {
+		ColorPoolBlock* block = ret->blocks + i;
+		block->parentData.octant = rebaseOctant(block->parentData.octant, original, ret);
+		block->colors = ret->colorNodes + (block->colors - original->colorNodes);
+	}
+
+	for(RB_Size i = 0; i < ret->numOctants; i++) {
+		ColorPoolOctant* octant = ret->octants + i;
+		octant->parentData.octant = rebaseOctant(octant->parentData.octant, original, ret);
+
+		if(octant->representative != NULL) {
+			octant->representative = ret->colorNodes + (octant->representative - original->colorNodes);
+		}
+
+		for(NodeChildrenSize j = 0; j < RB_COLOR_POOL_NODE_NUM_CHILDREN; j++) {
+			octant->children[j] = rebaseNode(octant->children[j], original, ret);
+		}
+	}
+
+	return ret;
+}
+
+RB_ColorChannel getChannelValueWithinBoundaries(RB_ColorChannel minVal, RB_ColorChannel maxVal, RB_ColorChannel toBound) {
+	RB_ColorChannel lowerBounded = toBound < minVal? minVal : toBound;
+	return lowerBounded > maxVal? maxVal : lowerBounded;
+}
+
+
+RB_ColorSquareDistance getSquareDistance(RB_Color a, RB_Color b) {
+	RB_ColorChannelDifference dR = a.r - b.r;
+	RB_ColorChannelDifference dG = a.g - b.g;
+	RB_ColorChannelDifference dB = a.b - b.b;
+
+	return (
+		((RB_ColorSquareDistance) dR * dR)
+		+ ((RB_ColorSquareDistance) dG * dG)
+		+ ((RB_ColorSquareDistance) dB * dB)
+	);
+}
+
+// RB_ColorSquareDistance getSquareDistance(RB_Color aRaw, RB_Color bRaw) {
+// 	HSVColor a = rgbToHSV(
+		
+// 	)
+
+// 	RB_ColorChannelDifference dR = a.r - b.r;
+// 	RB_ColorChannelDifference dG = a.g - b.g;
+// 	RB_ColorChannelDifference dB = a.b - b.b;
+
+// 	return (
+// 		((RB_ColorSquareDistance) dR * dR)
+// 		+ ((RB_ColorSquareDistance) dG * dG)
+// 		+ ((RB_ColorSquareDistance) dB * dB)
+// 	);
+// }
+
+// Using only the bounds of the octant and not the actual elements inside of it, what's the closest color
+// that this octant could possibly contain?
+RB_ColorSquareDistance getBlindClosestDistance(ColorPoolNode node, RB_Color color) {
+	switch(node.type) {
+		case POOL_NODE_EMPTY:
+			fprintf(stderr, "Attemping to get the closest distance to an empty node!\n");
+			return ~((RB_ColorSquareDistance) 0); // This should return the maximum possible value
+		case POOL_NODE_BLOCK:
+		case POOL_NODE_OCTANT: {
+			RB_Color minCorner = getNodeMinCorner(node);
+			RB_Color maxCorner = getNodeMaxCorner(node);
+			RB_Color closest = (RB_Color) {
+				.r = getChannelValueWithinBoundaries(minCorner.r, maxCorner.r, color.r),
+				.g = getChannelValueWithinBoundaries(minCorner.g, maxCorner.g, color.g),
+				.b = getChannelValueWithinBoundaries(minCorner.b, maxCorner.b, color.b),
+			};
+			return getSquareDistance(color, closest);
+		}
+		case POOL_NODE_COLOR: {
+			ColorPoolColorNode* colorNodePtr = node.colorNodePtr;
+			return getSquareDistance(color, colorNodePtr->color);
+		}
+	}
+}
+
+RB_ColorSquareDistance getBlindWorstDistance(ColorPoolNode node, RB_Color color) {
+	switch(node.type) {
+		case POOL_NODE_EMPTY:
+			fprintf(stderr, "Attemping to get the worst distance to an empty node!\n");
+			return 0;
+		case POOL_NODE_BLOCK:
+		case POOL_NODE_OCTANT: {
+			RB_Color minCorner = getNodeMinCorner(node);
+			RB_Color maxCorner = getNodeMaxCorner(node);
+			RB_Color furthestColor = {
+				.r = ((color.r * 2) - (minCorner.r + maxCorner.r)) > 0? minCorner.r : maxCorner.r,
+				.g = ((color.g * 2) - (minCorner.g + maxCorner.g)) > 0? minCorner.g : maxCorner.g,
+				.b = ((color.b * 2) - (minCorner.b + maxCorner.b)) > 0? minCorner.b : maxCorner.b
+			};
+			return getSquareDistance(color, furthestColor);
+		}
+		case POOL_NODE_COLOR: {
+			ColorPoolColorNode* colorNodePtr = node.colorNodePtr;
+			return getSquareDistance(color, colorNodePtr->color);
+		}
+	}
+}
+
+// The distance to a color that is definitely still in the node. Never worse than getBlindWorstDistance.
+RB_ColorSquareDistance getGuaranteedWorstDistance(ColorPoolNode node, RB_Color color) {
+	switch(node.type) {
+		case POOL_NODE_EMPTY:
+			fprintf(stderr, "Attemping to get the guaranteed worst distance to an empty node!\n");
+			return 0;
+		case POOL_NODE_OCTANT:
+			return getSquareDistance(color, node.octantNodePtr->representative->color);
+		case POOL_NODE_BLOCK:
+			return getSquareDistance(color, getNodeRepresentative(node)->color);
+		case POOL_NODE_COLOR:
+			return getSquareDistance(color, node.colorNodePtr->color);
+	}
+
+	fprintf(stderr, "Attemping to get the guaranteed worst distance to a node of unknown type %d!\n", (int) node.type);
+	return 0;
+}
+
+
+// Finds the block's closest colors with findClosestInBlock, and keeps them in the pool's blockClosest for the end of
+// the search.
+RB_ColorSquareDistance findClosestInQueuedBlock(RB_ColorPool* pool, ColorPoolBlock* block, RB_Color desired) {
+	BlockClosest* closest = pool->blockClosest + (block - pool->blocks);
+	closest->distance = findClosestInBlock(block, desired, &(closest->tieMask));
+	return closest->distance;
+}
+
+/*
+Basic algorithm (figured out by me!):
+1) Add the root node to the "node queue." At the start, it will be the only node in the queue.
+2) Initialize minWorstCase to the worst case of the root node, I guess.
+	- The "worst case" is the distance to the node's representative color, which the node is guaranteed to contain.
 3) Iterate through each node in the node queue.
 	3.1) If the node's best case is greater than minWorstCase, remove it from the queue.
 	3.2) If the node is an octant node, iterate through its children.
 		3.2.1) If the child's best case is greater than minWorstCase, do nothing.
 		3.2.2) If the child's best case is less than or equal to minWorstCase, add it to the node queue.
 		3.2.3) If the child's worst case is less than minWorstCase, set minWorstCase to the child's worst case value.
+			- A block that meets the threshold gets its exact closest distance instead, which is cheap (see
+			findClosestInBlock) and is the tightest worst case there is.
 	3.3) If the node is an octant node, remove it from the queue.
 4) If, during step 3, minWorstCase was updated or an octant was added to the queue, repeat step 3
-5) At this point, we know that the node queue only contains ideal colors. Choose one and return.
+5) At this point, we know that the node queue only contains blocks, and that the ideal colors are in them. Each
+block's closest colors were found when it was queued, so choose one of the closest of them uniformly at random.
+*/
+RB_Color findIdealAvailableColorInTree(RB_ColorPool* colorPool, RB_Color desired) {
+	ColorPoolNode* nodeQueue = colorPool->nodeQueue;
+	RB_Size nodeQueueSize = 1;
+	RB_Size nodeQueueNextSize = 0;
+
+	if(colorPool->root.type == POOL_NODE_EMPTY) {
+		fprintf(stderr, "Error: attempting to find ideal available color in an empty color pool!");
+		return (RB_Color) {
+			.r = 0,
+			.g = 0,
+			.b = 0
+		};
+	}
+
+	nodeQueue[0] = colorPool->root;
+	RB_ColorSquareDistance minWorstCase = (colorPool->root.type == POOL_NODE_BLOCK)?
+		findClosestInQueuedBlock(colorPool, colorPool->root.blockNodePtr, desired)
+		: getGuaranteedWorstDistance(colorPool->root, desired);
+	bool shouldIterateAgain = true;
+
+	while(shouldIterateAgain) {
+		shouldIterateAgain = false;
+
+		for(RB_Size i = 0; i < nodeQueueSize; i++) {
+			ColorPoolNode node = nodeQueue[i];
+			RB_ColorSquareDistance nodeBestCase = getBlindClosestDistance(node, desired);
+
+			if(nodeBestCase <= minWorstCase) {
+				if(node.type == POOL_NODE_OCTANT) {
+					ColorPoolOctant* octantNode = node.octantNodePtr;
+					if(colorPool->countsExpansions) {
+						octantNode->numExpansions++;
+					}
+
+					for(NodeChildrenSize j = 0; j < octantNode->numChildren; j++) {
+						ColorPoolNode child = octantNode->children[j];
+
+						RB_ColorSquareDistance childBestCase = getBlindClosestDistance(child, desired);
+						RB_ColorSquareDistance childWorstCase;
+
+						// Exactly the blocks that are about to be queued.
+						if(child.type == POOL_NODE_BLOCK && childBestCase <= minWorstCase) {
+							childWorstCase = findClosestInQueuedBlock(colorPool, child.blockNodePtr, desired);
+						} else {
+							childWorstCase = getGuaranteedWorstDistance(child, desired);
+						}
+
+						if(childBestCase <= minWorstCase) {
+							// add child to node queue
+
+							if(nodeQueueNextSize <= i) {
+								// If there's room at the start of the queue, add it there
+								// We're able to overwrite the node at position `i` because we already have its value saved
+								// in the node variable, and because it's an octant, it's going to be deleted anyway.
+
+								if(child.type == POOL_NODE_OCTANT) {
+									// Despite my algorithm saying that we should iterate again whenever we add
+									// an octant to the queue, the way we're handling adding nodes to the queue
+									// means that octants added to the end of the queue will be handled as though
+									// they were part of this iteration, so we don't need to iterate again for them.
+									// That's why we're only setting shouldIterateAgain to true when we're adding
+									// an octant to the beginning of the queue.
+									shouldIterateAgain = true;
+								}
+
+								nodeQueue[nodeQueueNextSize] = child;
+								nodeQueueNextSize++;
+
+
+							} else {
+								// If there's no room at the start of the queue, add it to the end.
+								nodeQueue[nodeQueueSize] = child;
+								nodeQueueSize++;
+							}
+						}
+						if(childWorstCase < minWorstCase) {
+							shouldIterateAgain = true;
+							minWorstCase = childWorstCase;
+						}
+					}
+				} else {
+					// At this point, we know the node is a block that meets the threshold for being kept
+					// We know that nodeQueueNextSize must be less than or equal to `i`, because `i` has necessarily
+					// increased by one since the last time nodeQueueNextSize could potentially have been equal to it.
+					
+					nodeQueue[nodeQueueNextSize] = node;
+					nodeQueueNextSize++;	
+				}
+			}
+		}
+
+		nodeQueueSize = nodeQueueNextSize;
+		nodeQueueNextSize = 0;
+	}
+
+	// So, at this point, the node queue should only contain blocks with ideal colors, and possibly some blocks whose
+	// closest colors are only a little worse. Choose uniformly between the ideal colors of all of them, replacing the
+	// chosen block with probability (its ideal colors / all ideal colors so far).
+	RB_ColorSquareDistance best = ~((RB_ColorSquareDistance) 0);
+	RB_Size numBest = 0;
+	ColorPoolBlock* chosenBlock = NULL;
+	uint64_t chosenTies = 0;
+
+	for(RB_Size i = 0; i < nodeQueueSize; i++) {
+		ColorPoolBlock* block = nodeQueue[i].blockNodePtr;
+
+		if(getBlindClosestDistance(nodeQueue[i], desired) > minWorstCase) {
+			continue;
+		}
+
+		// Every queued block's closest colors were found when it was queued, and nothing has been removed since.
+		BlockClosest closest = colorPool->blockClosest[block - colorPool->blocks];
+		RB_ColorSquareDistance dist = closest.distance;
+		uint64_t tieMask = closest.tieMask;
+
+		if(dist > best) {
+			continue;
+		}
+		if(dist < best) {
+			best = dist;
+			numBest = 0;
+		}
+
+		RB_Size numTies = __builtin_popcountll(tieMask);
+		numBest += numTies;
+		if(((RB_Size) rand()) % numBest < numTies) {
+			chosenBlock = block;
+			chosenTies = tieMask;
+		}
+	}
+
+	int bit = getRandomSetBit(chosenTies, ((RB_Size) rand()) % __builtin_popcountll(chosenTies));
+	return getBlockColorNode(chosenBlock, bit)->color;
+}
+
+RB_ColorSquareDistance getOctantSphereOffsetLowerBound(OctantSphereOffset offset) {
+	// Two cells that are d cells apart along a channel have (d - 1) whole cells between them, plus one step from the
+	// edge of one cell to the edge of the other.
+	RB_ColorSquareDistance ret = 0;
+	uint8_t deltas[3] = { offset.dR, offset.dG, offset.dB };
+
+	for(int i = 0; i < 3; i++) {
+		if(deltas[i] > 0) {
+			RB_ColorSquareDistance gap = ((RB_ColorSquareDistance) (deltas[i] - 1) * RB_OCTANT_SPHERE_CELL_SIZE) + 1;
+			ret += gap * gap;
+		}
+	}
+
+	return ret;
+}
+
+int compareOctantSphereOffsets(const void* a, const void* b) {
+	RB_ColorSquareDistance aBound = getOctantSphereOffsetLowerBound(*((const OctantSphereOffset*) a));
+	RB_ColorSquareDistance bBound = getOctantSphereOffsetLowerBound(*((const OctantSphereOffset*) b));
+
+	return (aBound > bBound) - (aBound < bBound);
+}
+
+void freeOctantSphere(OctantSphere* sphere) {
+	if(sphere == NULL) {
+		return;
+	}
+
+	free(sphere->shells);
+	free(sphere->offsets);
+	free(sphere);
+}
+
+OctantSphere* createOctantSphere(RB_ColorPool* pool) {
+	OctantSphere* ret = (OctantSphere*) malloc(sizeof(OctantSphere));
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	ret->rCells = getNumBlocksAlongChannel(pool->rSize);
+	ret->gCells = getNumBlocksAlongChannel(pool->gSize);
+	ret->bCells = getNumBlocksAlongChannel(pool->bSize);
+
+	// The desired color can be anywhere in the color cube, even outside of the pool's bounds, so the offsets have to
+	// reach across the whole cube.
+	RB_Size offsetsPerChannel = RB_MAXIMUM_COLOR_CHANNEL_RESOLUTION >> RB_OCTANT_SPHERE_CELL_SHIFT;
+	RB_Size numOffsets = offsetsPerChannel * offsetsPerChannel * offsetsPerChannel;
+
+	ret->offsets = (OctantSphereOffset*) malloc(sizeof(OctantSphereOffset) * numOffsets);
+	ret->shells = NULL;
+	ret->numShells = 0;
+
+	if(ret->offsets == NULL) {
+		freeOctantSphere(ret);
+		return NULL;
+	}
+
+	// Every offset a query could need lies in the first octant once signs are stripped.
+	RB_Size offsetIndex = 0;
+	for(RB_Size dR = 0; dR < offsetsPerChannel; dR++) {
+		for(RB_Size dG = 0; dG < offsetsPerChannel; dG++) {
+			for(RB_Size dB = 0; dB < offsetsPerChannel; dB++) {
+				ret->offsets[offsetIndex] = (OctantSphereOffset) { .dR = dR, .dG = dG, .dB = dB };
+				offsetIndex++;
+			}
+		}
+	}
+
+	qsort(ret->offsets, numOffsets, sizeof(OctantSphereOffset), compareOctantSphereOffsets);
+
+	// Group offsets with equal lower bounds into shells.
+	for(RB_Size i = 0; i < numOffsets; i++) {
+		if(i == 0 || compareOctantSphereOffsets(ret->offsets + i - 1, ret->offsets + i) != 0) {
+			ret->numShells++;
+		}
+	}
+
+	ret->shells = (OctantSphereShell*) malloc(sizeof(OctantSphereShell) * ret->numShells);
+
+	if(ret->shells == NULL) {
+		freeOctantSphere(ret);
+		return NULL;
+	}
+
+	RB_Size shellIndex = -1;
+	for(RB_Size i = 0; i < numOffsets; i++) {
+		RB_ColorSquareDistance lowerBound = getOctantSphereOffsetLowerBound(ret->offsets[i]);
+
+		if(shellIndex < 0 || ret->shells[shellIndex].lowerBound != lowerBound) {
+			shellIndex++;
+			ret->shells[shellIndex] = (OctantSphereShell) {
+				.lowerBound = lowerBound,
+				.firstOffset = i,
+				.numOffsets = 0
+			};
+		}
+
+		ret->shells[shellIndex].numOffsets++;
+	}
+
+	return ret;
+}
+
+bool RB_setColorPoolSearchEngine(RB_ColorPool* pool, RB_ColorPoolSearchEngine engine) {
+	if(engine == RB_COLOR_POOL_ENGINE_OCTANT_SPHERE && pool->sphere == NULL) {
+		pool->sphere = createOctantSphere(pool);
+
+		if(pool->sphere == NULL) {
+			fprintf(stderr, "Error setting color pool search engine: could not allocate the octant sphere!\n");
+			return false;
+		}
+	}
+
+	pool->engine = engine;
+	return true;
+}
+
+/*
+The octant-sphere method:
+1) Find the cell that contains the desired color.
+2) Visit the precomputed shells in order. Every cell in a shell is at least the shell's lowerBound away from any color
+in the desired color's cell, so once a shell's lowerBound exceeds the best distance found so far, no remaining cell can
+contain a better color and the search is over.
+3) The offsets are stored for one octant only, so each offset is mirrored across every channel it is nonzero in.
+4) Each cell is one of the pool's blocks, so its closest colors are found all at once by findClosestInBlock.
+*/
+RB_Color findIdealAvailableColorInSphere(RB_ColorPool* pool, RB_Color desired) {
+	OctantSphere* sphere = pool->sphere;
+
+	RB_Size centerR = desired.r >> RB_OCTANT_SPHERE_CELL_SHIFT;
+	RB_Size centerG = desired.g >> RB_OCTANT_SPHERE_CELL_SHIFT;
+	RB_Size centerB = desired.b >> RB_OCTANT_SPHERE_CELL_SHIFT;
+
+	// The largest offset along each channel that still lands on one of the pool's cells.
+	RB_Size maxReachR = (centerR > sphere->rCells - 1 - centerR)? centerR : sphere->rCells - 1 - centerR;
+	RB_Size maxReachG = (centerG > sphere->gCells - 1 - centerG)? centerG : sphere->gCells - 1 - centerG;
+	RB_Size maxReachB = (centerB > sphere->bCells - 1 - centerB)? centerB : sphere->bCells - 1 - centerB;
+
+	RB_ColorSquareDistance best = ~((RB_ColorSquareDistance) 0);
+	RB_Size numBest = 0;
+	ColorPoolBlock* chosenBlock = NULL;
+	uint64_t chosenTies = 0;
+
+	for(RB_Size shellIndex = 0; shellIndex < sphere->numShells; shellIndex++) {
+		OctantSphereShell shell = sphere->shells[shellIndex];
+
+		if(shell.lowerBound > best) {
+			break;
+		}
+
+		for(RB_Size i = shell.firstOffset; i < shell.firstOffset + shell.numOffsets; i++) {
+			OctantSphereOffset offset = sphere->offsets[i];
+
+			// Skip offsets that leave the pool's cells in every direction.
+			if(offset.dR > maxReachR || offset.dG > maxReachG || offset.dB > maxReachB) {
+				continue;
+			}
+
+			for(int signs = 0; signs < 8; signs++) {
+				// Don't visit the same cell twice by negating a zero.
+				if(((signs & 1) && offset.dR == 0) || ((signs & 2) && offset.dG == 0) || ((signs & 4) && offset.dB == 0)) {
+					continue;
+				}
+
+				RB_Size cellR = centerR + ((signs & 1)? -((RB_Size) offset.dR) : offset.dR);
+				RB_Size cellG = centerG + ((signs & 2)? -((RB_Size) offset.dG) : offset.dG);
+				RB_Size cellB = centerB + ((signs & 4)? -((RB_Size) offset.dB) : offset.dB);
+
+				if(
+					cellR < 0 || cellR >= sphere->rCells
+					|| cellG < 0 || cellG >= sphere->gCells
+					|| cellB < 0 || cellB >= sphere->bCells
+				) {
+					continue;
+				}
+
+				ColorPoolBlock* block = findBlock(pool, cellR, cellG, cellB);
+
+				if(block == NULL || block->availableMask == 0) {
+					continue;
+				}
+
+				uint64_t tieMask;
+				RB_ColorSquareDistance dist = findClosestInBlock(block, desired, &tieMask);
+
+				if(dist > best) {
+					continue;
+				}
+				if(dist < best) {
+					best = dist;
+					numBest = 0;
+				}
+
+				// Like the tree search, choose uniformly between equally ideal colors.
+				RB_Size numTies = __builtin_popcountll(tieMask);
+				numBest += numTies;
+				if(((RB_Size) rand()) % numBest < numTies) {
+					chosenBlock = block;
+					chosenTies = tieMask;
+				}
+			}
+		}
+	}
+
+	if(numBest == 0) {
+		fprintf(stderr, "Error: attempting to find ideal available color in an empty color pool!");
+		return (RB_Color) {
+			.r = 0,
+			.g = 0,
+			.b = 0
+		};
+	}
+
+	int bit = getRandomSetBit(chosenTies, ((RB_Size) rand()) % __builtin_popcountll(chosenTies));
+	return getBlockColorNode(chosenBlock, bit)->color;
+}
+
+RB_Color RB_findIdealAvailableColor(RB_ColorPool* colorPool, RB_Color desired) {
+	switch(colorPool->engine) {
+		case RB_COLOR_POOL_ENGINE_OCTANT_SPHERE:
+			return findIdealAvailableColorInSphere(colorPool, desired);
+		case RB_COLOR_POOL_ENGINE_OCTANT_TREE:
+		default:
+			return findIdealAvailableColorInTree(colorPool, desired);
+	}
+}
+
+// Moves the entry at index i of the max-heap down until neither of its children is further away than it is.
+void siftDownKNearestHeap(RB_Color* colors, RB_ColorSquareDistance* dists, RB_Size size, RB_Size i) {
+	while(true) {
+		RB_Size largest = i;
+		RB_Size left = (i * 2) + 1;
+		RB_Size right = left + 1;
+
+		if(left < size && dists[left] > dists[largest]) {
+			largest = left;
+		}
+		if(right < size && dists[right] > dists[largest]) {
+			largest = right;
+		}
+		if(largest == i) {
+			return;
+		}
+
+		RB_Color tmpColor = colors[i];
+		RB_ColorSquareDistance tmpDist = dists[i];
+		colors[i] = colors[largest];
+		dists[i] = dists[largest];
+		colors[largest] = tmpColor;
+		dists[largest] = tmpDist;
+
+		i = largest;
+	}
+}
+
+// Adds a color to the k-nearest max-heap, replacing the furthest color if the heap is already full.
+void addToKNearestHeap(RB_Color* out, RB_ColorSquareDistance* outDist, RB_Size* heapSize, RB_Size k, RB_Color color, RB_ColorSquareDistance dist) {
+	if(*heapSize < k) {
+		// Sift the new color up to its place in the heap.
+		RB_Size i = *heapSize;
+		(*heapSize)++;
+		while(i > 0 && outDist[(i - 1) / 2] < dist) {
+			out[i] = out[(i - 1) / 2];
+			outDist[i] = outDist[(i - 1) / 2];
+			i = (i - 1) / 2;
+		}
+		out[i] = color;
+		outDist[i] = dist;
+	} else if(dist < outDist[0]) {
+		// Replace the furthest color.
+		out[0] = color;
+		outDist[0] = dist;
+		siftDownKNearestHeap(out, outDist, *heapSize, 0);
+	}
+}
+
+/*
+A depth-first search that keeps the best k colors found so far in a max-heap (stored directly in out and outDist), so
+the furthest of them is always at the top. Once the heap is full, any node whose blind closest distance is further
+than the top of the heap can't contribute and is skipped. Children are pushed furthest-first so that the closest
+child is visited next, which fills the heap with good candidates early.
+*/
+RB_Size RB_findKNearestAvailableColors(
+	RB_ColorPool* pool,
+	RB_Color desired,
+	RB_Size k,
+	RB_Color* out,
+	RB_ColorSquareDistance* outDist
+) {
+	if(k <= 0 || pool->root.type == POOL_NODE_EMPTY) {
+		return 0;
+	}
+
+	ColorPoolNode* stack = pool->nodeQueue;
+	RB_Size stackSize = 1;
+	RB_Size heapSize = 0;
+
+	stack[0] = pool->root;
+
+	while(stackSize > 0) {
+		stackSize--;
+		ColorPoolNode node = stack[stackSize];
+
+		if(heapSize == k && getBlindClosestDistance(node, desired) > outDist[0]) {
+			continue;
+		}
+
+		if(node.type == POOL_NODE_BLOCK) {
+			ColorPoolBlock* block = node.blockNodePtr;
+
+			for(uint64_t mask = block->availableMask; mask != 0; mask &= mask - 1) {
+				RB_Color color = getBlockBitColor(block, __builtin_ctzll(mask));
+				addToKNearestHeap(out, outDist, &heapSize, k, color, getSquareDistance(desired, color));
+			}
+			continue;
+		}
+
+		ColorPoolOctant* octant = node.octantNodePtr;
+		RB_ColorSquareDistance childDists[RB_COLOR_POOL_NODE_NUM_CHILDREN];
+		ColorPoolNode children[RB_COLOR_POOL_NODE_NUM_CHILDREN];
+		NodeChildrenSize numChildren = 0;
+
+		// Insertion sort the children by decreasing closest distance.
+		for(NodeChildrenSize i = 0; i < octant->numChildren; i++) {
+			ColorPoolNode child = octant->children[i];
+			RB_ColorSquareDistance childDist = getBlindClosestDistance(child, desired);
+
+			if(heapSize == k && childDist > outDist[0]) {
+				continue;
+			}
+
+			NodeChildrenSize j = numChildren;
+			while(j > 0 && childDists[j - 1] < childDist) {
+				childDists[j] = childDists[j - 1];
+				children[j] = children[j - 1];
+				j--;
+			}
+			childDists[j] = childDist;
+			children[j] = child;
+			numChildren++;
+		}
+
+		for(NodeChildrenSize i = 0; i < numChildren; i++) {
+			stack[stackSize] = children[i];
+			stackSize++;
+		}
+	}
+
+	// Heap sort so the results come out closest first.
+	for(RB_Size end = heapSize - 1; end > 0; end--) {
+		RB_Color tmpColor = out[0];
+		RB_ColorSquareDistance tmpDist = outDist[0];
+		out[0] = out[end];
+		outDist[0] = outDist[end];
+		out[end] = tmpColor;
+		outDist[end] = tmpDist;
+
+		siftDownKNearestHeap(out, outDist, end, 0);
+	}
+
+	return heapSize;
+}
+
+// Returns true if the node's bounds overlap the box at all.
+bool nodeOverlapsBox(ColorPoolNode node, RB_Color boxMin, RB_Color boxMax) {
+	RB_Color nodeMin = getNodeMinCorner(node);
+	RB_Color nodeMax = getNodeMaxCorner(node);
+
+	return (
+		nodeMin.r <= boxMax.r && nodeMax.r >= boxMin.r
+		&& nodeMin.g <= boxMax.g && nodeMax.g >= boxMin.g
+		&& nodeMin.b <= boxMax.b && nodeMax.b >= boxMin.b
+	);
+}
+
+// Like getBlindClosestDistance, but only considers the part of the node that's inside the box.
+// The node must overlap the box.
+RB_ColorSquareDistance getBlindClosestDistanceInBox(ColorPoolNode node, RB_Color color, RB_Color boxMin, RB_Color boxMax) {
+	RB_Color nodeMin = getNodeMinCorner(node);
+	RB_Color nodeMax = getNodeMaxCorner(node);
+
+	RB_Color closest = {
+		.r = getChannelValueWithinBoundaries(
+			nodeMin.r > boxMin.r? nodeMin.r : boxMin.r, nodeMax.r < boxMax.r? nodeMax.r : boxMax.r, color.r
+		),
+		.g = getChannelValueWithinBoundaries(
+			nodeMin.g > boxMin.g? nodeMin.g : boxMin.g, nodeMax.g < boxMax.g? nodeMax.g : boxMax.g, color.g
+		),
+		.b = getChannelValueWithinBoundaries(
+			nodeMin.b > boxMin.b? nodeMin.b : boxMin.b, nodeMax.b < boxMax.b? nodeMax.b : boxMax.b, color.b
+		)
+	};
+
+	return getSquareDistance(color, closest);
+}
+
+/*
+A depth-first search like RB_findKNearestAvailableColors with k = 1, except that nodes which don't overlap the box are
+never entered, and distances to nodes that only partly overlap it are measured to the overlapping part.
+Ties are broken uniformly at random with reservoir sampling, so no extra storage is needed.
+*/
+bool RB_findIdealAvailableColorInBox(
+	RB_ColorPool* pool,
+	RB_Color desired,
+	RB_Color boxMin,
+	RB_Color boxMax,
+	RB_Color* out
+) {
+	if(pool->root.type == POOL_NODE_EMPTY || !nodeOverlapsBox(pool->root, boxMin, boxMax)) {
+		return false;
+	}
+
+	ColorPoolNode* stack = pool->nodeQueue;
+	RB_Size stackSize = 1;
+	stack[0] = pool->root;
+
+	RB_ColorSquareDistance best = ~((RB_ColorSquareDistance) 0);
+	RB_Size numBest = 0;
+	ColorPoolColorNode* chosen = NULL;
+
+	while(stackSize > 0) {
+		stackSize--;
+		ColorPoolNode node = stack[stackSize];
+
+		if(getBlindClosestDistanceInBox(node, desired, boxMin, boxMax) > best) {
+			continue;
+		}
+
+		if(node.type == POOL_NODE_BLOCK) {
+			ColorPoolBlock* block = node.blockNodePtr;
+
+			for(uint64_t mask = block->availableMask; mask != 0; mask &= mask - 1) {
+				int bit = __builtin_ctzll(mask);
+				RB_Color color = getBlockBitColor(block, bit);
+
+				if(
+					color.r < boxMin.r || color.r > boxMax.r
+					|| color.g < boxMin.g || color.g > boxMax.g
+					|| color.b < boxMin.b || color.b > boxMax.b
+				) {
+					continue;
+				}
+
+				RB_ColorSquareDistance dist = getSquareDistance(desired, color);
+
+				if(dist > best) {
+					continue;
+				}
+				if(dist < best) {
+					best = dist;
+					numBest = 0;
+				}
+				numBest++;
+				if(rand() % numBest == 0) {
+					chosen = getBlockColorNode(block, bit);
+				}
+			}
+			continue;
+		}
+
+		ColorPoolOctant* octant = node.octantNodePtr;
+		RB_ColorSquareDistance childDists[RB_COLOR_POOL_NODE_NUM_CHILDREN];
+		ColorPoolNode children[RB_COLOR_POOL_NODE_NUM_CHILDREN];
+		NodeChildrenSize numChildren = 0;
+
+		// Insertion sort the overlapping children by decreasing closest distance, so the closest is visited first.
+		for(NodeChildrenSize i = 0; i < octant->numChildren; i++) {
+			ColorPoolNode child = octant->children[i];
+
+			if(!nodeOverlapsBox(child, boxMin, boxMax)) {
+				continue;
+			}
+
+			RB_ColorSquareDistance childDist = getBlindClosestDistanceInBox(child, desired, boxMin, boxMax);
+
+			if(childDist > best) {
+				continue;
+			}
+
+			NodeChildrenSize j = numChildren;
+			while(j > 0 && childDists[j - 1] < childDist) {
+				childDists[j] = childDists[j - 1];
+				children[j] = children[j - 1];
+				j--;
+			}
+			childDists[j] = childDist;
+			children[j] = child;
+			numChildren++;
+		}
+
+		for(NodeChildrenSize i = 0; i < numChildren; i++) {
+			stack[stackSize] = children[i];
+			stackSize++;
+		}
+	}
+
+	if(chosen == NULL) {
+		return false;
+	}
+
+	*out = chosen->color;
+	return true;
+}
+
+// Returns a random value in [0, n). Combines two calls to rand() so that n can be larger than RAND_MAX.
+RB_Size getRandomIndexBelow(RB_Size n) {
+	RB_USize wide = (((RB_USize) rand()) * ((RB_USize) RAND_MAX + 1)) + (RB_USize) rand();
+	return (RB_Size) (wide % (RB_USize) n);
+}
+
+// Returns the node's index-th available color, counting in child order. Takes O(depth) time.
+ColorPoolColorNode* getNthAvailableColorInNode(ColorPoolNode node, RB_Size index) {
+	while(node.type == POOL_NODE_OCTANT) {
+		ColorPoolOctant* octant = node.octantNodePtr;
+		NodeChildrenSize i = 0;
+
+		while(i < octant->numChildren - 1 && index >= getNodeAvailableCount(octant->children[i])) {
+			index -= getNodeAvailableCount(octant->children[i]);
+			i++;
+		}
+
+		node = octant->children[i];
+	}
+
+	if(node.type == POOL_NODE_COLOR) {
+		return node.colorNodePtr;
+	}
+
+	// Count through the block's available colors. Each one covers as many indexes as it has remaining uses.
+	ColorPoolBlock* block = node.blockNodePtr;
+	uint64_t mask = block->availableMask;
+	ColorPoolColorNode* colorNode = getBlockColorNode(block, __builtin_ctzll(mask));
+
+	while(index >= colorNode->remaining) {
+		index -= colorNode->remaining;
+		mask &= mask - 1;
+		colorNode = getBlockColorNode(block, __builtin_ctzll(mask));
+	}
+
+	return colorNode;
+}
+
+// Adds the largest nodes at or below `node` that lie entirely within the band to the node queue, and returns the total
+// number of colors in the nodes that were added.
+RB_Size collectNodesInBand(
+	RB_ColorPool* pool,
+	ColorPoolNode node,
+	RB_Color desired,
+	RB_ColorSquareDistance minSquareDist,
+	RB_ColorSquareDistance maxSquareDist,
+	RB_Size* numCollected
+) {
+	RB_ColorSquareDistance closest = getBlindClosestDistance(node, desired);
+	if(closest > maxSquareDist) {
+		return 0;
+	}
+
+	RB_ColorSquareDistance worst = getBlindWorstDistance(node, desired);
+	if(worst < minSquareDist) {
+		return 0;
+	}
+
+	if(closest >= minSquareDist && worst <= maxSquareDist) {
+		pool->nodeQueue[*numCollected] = node;
+		(*numCollected)++;
+		return getNodeAvailableCount(node);
+	}
+
+	if(node.type == POOL_NODE_BLOCK) {
+		// The block straddles an edge of the band, so collect its colors that are inside the band one at a time.
+		ColorPoolBlock* block = node.blockNodePtr;
+		RB_Size ret = 0;
+
+		for(uint64_t mask = block->availableMask; mask != 0; mask &= mask - 1) {
+			ColorPoolColorNode* colorNode = getBlockColorNode(block, __builtin_ctzll(mask));
+			RB_ColorSquareDistance dist = getSquareDistance(desired, colorNode->color);
+
+			if(dist >= minSquareDist && dist <= maxSquareDist) {
+				pool->nodeQueue[*numCollected] = (ColorPoolNode) {
+					.type = POOL_NODE_COLOR,
+					.colorNodePtr = colorNode
+				};
+				(*numCollected)++;
+				ret += colorNode->remaining;
+			}
+		}
+
+		return ret;
+	}
+
+	ColorPoolOctant* octant = node.octantNodePtr;
+	RB_Size ret = 0;
+
+	for(NodeChildrenSize i = 0; i < octant->numChildren; i++) {
+		ret += collectNodesInBand(pool, octant->children[i], desired, minSquareDist, maxSquareDist, numCollected);
+	}
+
+	return ret;
+}
+
+/*
+1) Walk the tree, skipping nodes whose [closest, worst] distance range doesn't overlap the band at all and stopping at
+nodes whose range lies entirely within it. Only nodes that straddle one of the band's edges are opened up, so the
+amount of work depends on the band's surface rather than on the size of the pool.
+2) Every collected node is entirely within the band, so pick one of their colors uniformly by weighting each node by
+its number of available colors, then walk down to that color using the per-octant counts.
 */
-RB_Color RB_findIdealAvailableColor(RB_ColorPool* colorPool, RB_Color desired) {
-	ColorPoolNode* nodeQueue = colorPool->nodeQueue;
-	RB_Size nodeQueueSize = 1;
-	RB_Size nodeQueueNextSize = 0;
+bool RB_findRandomAvailableColorInBand(
+	RB_ColorPool* pool,
+	RB_Color desired,
+	RB_ColorSquareDistance minSquareDist,
+	RB_ColorSquareDistance maxSquareDist,
+	RB_Color* out
+) {
+	if(pool->root.type == POOL_NODE_EMPTY || minSquareDist > maxSquareDist) {
+		return false;
+	}
 
-	if(colorPool->root.type == POOL_NODE_EMPTY) {
-		fprintf(stderr, "Error: attempting to find ideal available color in an empty color pool!");
-		return (RB_Color) {
-			.r = 0,
-			.g = 0,
-			.b = 0
-		};
+	RB_Size numCollected = 0;
+	RB_Size numColors = collectNodesInBand(pool, pool->root, desired, minSquareDist, maxSquareDist, &numCollected);
+
+	if(numColors == 0) {
+		return false;
 	}
 
-	nodeQueue[0] = colorPool->root;
-	RB_ColorSquareDistance minWorstCase = getBlindWorstDistance(colorPool->root, desired);
-	bool shouldIterateAgain = true;
+	RB_Size index = getRandomIndexBelow(numColors);
+	RB_Size nodeIndex = 0;
 
-	while(shouldIterateAgain) {
-		shouldIterateAgain = false;
+	while(index >= getNodeAvailableCount(pool->nodeQueue[nodeIndex])) {
+		index -= getNodeAvailableCount(pool->nodeQueue[nodeIndex]);
+		nodeIndex++;
+	}
 
-		for(RB_Size i = 0; i < nodeQueueSize; i++) {
-			ColorPoolNode node = nodeQueue[i];
-			RB_ColorSquareDistance nodeBestCase = getBlindClosestDistance(node, desired);
+	*out = getNthAvailableColorInNode(pool->nodeQueue[nodeIndex], index)->color;
+	return true;
+}
 
-			if(nodeBestCase <= minWorstCase) {
-				if(node.type == POOL_NODE_OCTANT) {
-					ColorPoolOctant* octantNode = node.octantNodePtr;
-					for(NodeChildrenSize j = 0; j < octantNode->numChildren; j++) {
-						ColorPoolNode child = octantNode->children[j];
+// The square distance from the color to the closest color in the set.
+RB_ColorSquareDistance getSquareDistanceToSet(RB_Color color, const RB_Color* set, RB_Size setSize) {
+	RB_ColorSquareDistance ret = getSquareDistance(color, set[0]);
 
-						RB_ColorSquareDistance childBestCase = getBlindClosestDistance(child, desired);
-						RB_ColorSquareDistance childWorstCase = getBlindWorstDistance(child, desired);
+	for(RB_Size i = 1; i < setSize; i++) {
+		RB_ColorSquareDistance dist = getSquareDistance(color, set[i]);
+		if(dist < ret) {
+			ret = dist;
+		}
+	}
 
-						if(childBestCase <= minWorstCase) {
-							// add child to node queue
+	return ret;
+}
 
-							if(nodeQueueNextSize <= i) {
-								// If there's room at the start of the queue, add it there
-								// We're able to overwrite the node at position `i` because we already have its value saved
-								// in the node variable, and because it's an octant, it's going to be deleted anyway.
+// No color in the node can be farther than this from the closest color in the set.
+RB_ColorSquareDistance getBlindWorstDistanceToSet(ColorPoolNode node, const RB_Color* set, RB_Size setSize) {
+	RB_ColorSquareDistance ret = getBlindWorstDistance(node, set[0]);
 
-								if(child.type == POOL_NODE_OCTANT) {
-									// Despite my algorithm saying that we should iterate again whenever we add
-									// an octant to the queue, the way we're handling adding nodes to the queue
-									// means that octants added to the end of the queue will be handled as though
-									// they were part of this iteration, so we don't need to iterate again for them.
-									// That's why we're only setting shouldIterateAgain to true when we're adding
-									// an octant to the beginning of the queue.
-									shouldIterateAgain = true;
-								}
+	for(RB_Size i = 1; i < setSize && ret > 0; i++) {
+		RB_ColorSquareDistance dist = getBlindWorstDistance(node, set[i]);
+		if(dist < ret) {
+			ret = dist;
+		}
+	}
 
-								nodeQueue[nodeQueueNextSize] = child;
-								nodeQueueNextSize++;
+	return ret;
+}
 
+/*
+A depth-first search for the color whose closest color in the set is as far away as possible.
+- Every octant's representative is a real color, so it's a candidate as soon as the octant is reached. That gets
+a good best distance early, before any leaves are reached.
+- A node whose blind worst distance to the set is no better than the best distance so far can't contain anything
+better, so it's skipped.
+- Children are pushed so that the one with the largest bound is searched first.
+*/
+bool RB_findFarthestAvailableColorFromSet(RB_ColorPool* pool, const RB_Color* set, RB_Size setSize, RB_Color* out) {
+	if(setSize <= 0 || pool->root.type == POOL_NODE_EMPTY) {
+		return false;
+	}
 
-							} else {
-								// If there's no room at the start of the queue, add it to the end.
-								nodeQueue[nodeQueueSize] = child;
-								nodeQueueSize++;
-							}
-						}
-						if(childWorstCase < minWorstCase) {
-							shouldIterateAgain = true;
-							minWorstCase = childWorstCase;
-						}
-					}
-				} else {
-					// At this point, we know the node is a color that meets the threshold for being kept
-					// We know that nodeQueueNextSize must be less than or equal to `i`, because `i` has necessarily
-					// increased by one since the last time nodeQueueNextSize could potentially have been equal to it.
-					
-					nodeQueue[nodeQueueNextSize] = node;
-					nodeQueueNextSize++;	
+	ColorPoolNode* stack = pool->nodeQueue;
+	RB_Size stackSize = 1;
+
+	ColorPoolColorNode* best = getNodeRepresentative(pool->root);
+	RB_ColorSquareDistance bestDist = getSquareDistanceToSet(best->color, set, setSize);
+
+	stack[0] = pool->root;
+
+	while(stackSize > 0) {
+		stackSize--;
+		ColorPoolNode node = stack[stackSize];
+
+		if(getBlindWorstDistanceToSet(node, set, setSize) <= bestDist) {
+			continue;
+		}
+
+		ColorPoolColorNode* candidate = getNodeRepresentative(node);
+		RB_ColorSquareDistance candidateDist = getSquareDistanceToSet(candidate->color, set, setSize);
+
+		if(candidateDist > bestDist) {
+			best = candidate;
+			bestDist = candidateDist;
+		}
+
+		if(node.type == POOL_NODE_BLOCK) {
+			ColorPoolBlock* block = node.blockNodePtr;
+
+			for(uint64_t mask = block->availableMask; mask != 0; mask &= mask - 1) {
+				ColorPoolColorNode* colorNode = getBlockColorNode(block, __builtin_ctzll(mask));
+				RB_ColorSquareDistance dist = getSquareDistanceToSet(colorNode->color, set, setSize);
+
+				if(dist > bestDist) {
+					best = colorNode;
+					bestDist = dist;
 				}
 			}
+			continue;
 		}
 
-		nodeQueueSize = nodeQueueNextSize;
-		nodeQueueNextSize = 0;
+		ColorPoolOctant* octant = node.octantNodePtr;
+		RB_ColorSquareDistance childBounds[RB_COLOR_POOL_NODE_NUM_CHILDREN];
+		ColorPoolNode children[RB_COLOR_POOL_NODE_NUM_CHILDREN];
+		NodeChildrenSize numChildren = 0;
+
+		// Insertion sort the children by increasing bound, so the most promising child ends up on top of the stack.
+		for(NodeChildrenSize i = 0; i < octant->numChildren; i++) {
+			ColorPoolNode child = octant->children[i];
+			RB_ColorSquareDistance childBound = getBlindWorstDistanceToSet(child, set, setSize);
+
+			if(childBound <= bestDist) {
+				continue;
+			}
+
+			NodeChildrenSize j = numChildren;
+			while(j > 0 && childBounds[j - 1] > childBound) {
+				childBounds[j] = childBounds[j - 1];
+				children[j] = children[j - 1];
+				j--;
+			}
+			childBounds[j] = childBound;
+			children[j] = child;
+			numChildren++;
+		}
+
+		for(NodeChildrenSize i = 0; i < numChildren; i++) {
+			stack[stackSize] = children[i];
+			stackSize++;
+		}
 	}
 
-	// So, at this point, the node queue should only contain ideal colors. 
-	RB_Size colorNodeIndex = ((RB_Size) rand()) % nodeQueueSize;
-	ColorPoolNode nodeToReturn = nodeQueue[colorNodeIndex];
-	RB_Color ret = nodeToReturn.colorNodePtr->color;
+	*out = best->color;
+	return true;
+}
+
+RB_Color RB_findFarthestAvailableColor(RB_ColorPool* pool, RB_Color from) {
+	RB_Color ret = {
+		.r = 0,
+		.g = 0,
+		.b = 0
+	};
+
+	if(!RB_findFarthestAvailableColorFromSet(pool, &from, 1, &ret)) {
+		fprintf(stderr, "Error: attempting to find the farthest available color in an empty color pool!\n");
+	}
 
 	return ret;
 }
 
+RB_Color RB_sampleRandomAvailableColor(RB_ColorPool* pool) {
+	if(pool->root.type == POOL_NODE_EMPTY) {
+		fprintf(stderr, "Error: attempting to sample a random color from an empty color pool!\n");
+		return (RB_Color) {
+			.r = 0,
+			.g = 0,
+			.b = 0
+		};
+	}
+
+	// Every octant knows how many uses are left under it, so picking a uniformly random index and descending to it
+	// chooses every remaining use with equal probability.
+	RB_Size index = getRandomIndexBelow(getNodeAvailableCount(pool->root));
+	return getNthAvailableColorInNode(pool->root, index)->color;
+}
+
 bool RB_colorIsAvailableInPool(RB_ColorPool* pool, RB_Color toFind) {
-	if(toFind.r >= pool->rSize || toFind.g >= pool->gSize || toFind.b >= pool->bSize) {
+	ColorPoolColorNode* colorNode = findColorNode(pool, toFind);
+
+	return colorNode != NULL && colorNode->remaining > 0;
+}
+
+// Makes sure the journal has room for numEntries more entries, so the mutations after this can't fail halfway through.
+bool reservePoolJournal(RB_ColorPool* pool, RB_Size numEntries) {
+	RB_Size needed = pool->journalSize + numEntries;
+
+	if(needed <= pool->journalCapacity) {
+		return true;
+	}
+
+	RB_Size newCapacity = (pool->journalCapacity == 0)? 256 : pool->journalCapacity * 2;
+	while(newCapacity < needed) {
+		newCapacity *= 2;
+	}
+
+	PoolJournalEntry* newJournal = (PoolJournalEntry*) realloc(pool->journal, sizeof(PoolJournalEntry) * newCapacity);
+
+	if(newJournal == NULL) {
 		return false;
 	}
-	RB_Size colorNodeIndex = getDataPosition(toFind.r, toFind.g, toFind.b, pool->gSize, pool->bSize);
 
-	return pool->colorNodes[colorNodeIndex].isAvailable;
+	pool->journal = newJournal;
+	pool->journalCapacity = newCapacity;
+	return true;
 }
 
-bool RB_removeColorFromPool(RB_ColorPool* pool, RB_Color toRemove) {
-	if(toRemove.r >= pool->rSize || toRemove.g >= pool->gSize || toRemove.b >= pool->bSize) {
+// If the pool is journaling, saves the current value at address so that it can be restored by RB_poolRollback.
+// Returns false if the journal could not be grown, in which case the mutation must not be made.
+bool recordPoolMutation(RB_ColorPool* pool, void* address, size_t size) {
+	if(!pool->isJournaling) {
+		return true;
+	}
+
+	if(!reservePoolJournal(pool, 1)) {
+		fprintf(stderr, "Error recording color pool mutation: could not grow the journal!\n");
 		return false;
 	}
 
-	RB_Size colorNodeIndex = getDataPosition(toRemove.r, toRemove.g, toRemove.b, pool->gSize, pool->bSize);
-	ColorPoolColorNode* colorNode = &(pool->colorNodes[colorNodeIndex]);
+	PoolJournalEntry* entry = pool->journal + pool->journalSize;
+	entry->address = address;
+	entry->size = size;
+	memcpy(&(entry->oldValue), address, size);
+	pool->journalSize++;
+	return true;
+}
 
-	// If colorNode has already been removed, it can't be removed again. 
-	if(!colorNode->isAvailable) {
-		return false;
+// updateNodeParentData, but recorded in the journal.
+void setNodeParentDataRecorded(RB_ColorPool* pool, ColorPoolNode node, ColorPoolOctant* newParent, NodeChildrenSize newIndex) {
+	switch(node.type) {
+		case POOL_NODE_BLOCK:
+			recordPoolMutation(pool, &(node.blockNodePtr->parentData), sizeof(ChildNodeParentData));
+			break;
+		case POOL_NODE_OCTANT:
+			recordPoolMutation(pool, &(node.octantNodePtr->parentData), sizeof(ChildNodeParentData));
+			break;
+		case POOL_NODE_COLOR:
+		case POOL_NODE_EMPTY:
+			break;
 	}
 
-	colorNode->isAvailable = false;
+	updateNodeParentData(node, newParent, newIndex);
+}
 
-	// If the colorNode has no parent, then it is presumably the root. Set the root to empty and return.
-	if(colorNode->parentData.octant == NULL) {
-		printf("Removing last color from the pool.\n");
-		pool->root = emptyColorPoolNode;
-		return true;
+RB_PoolMark RB_poolMark(RB_ColorPool* pool) {
+	pool->isJournaling = true;
+	return pool->journalSize;
+}
+
+void RB_poolRollback(RB_ColorPool* pool, RB_PoolMark mark) {
+	if(!pool->isJournaling || mark < 0 || mark > pool->journalSize) {
+		fprintf(stderr, "Error rolling back color pool: %ld is not a valid mark!\n", (long) mark);
+		return;
 	}
 
-	// Remove the colorNode from its parent
-	ColorPoolOctant* octant = colorNode->parentData.octant;
+	// Undo the mutations newest first, so each location ends up with the value it had at the mark.
+	while(pool->journalSize > mark) {
+		pool->journalSize--;
+		PoolJournalEntry* entry = pool->journal + pool->journalSize;
+		memcpy(entry->address, &(entry->oldValue), entry->size);
+	}
+}
+
+void RB_poolCommit(RB_ColorPool* pool) {
+	pool->isJournaling = false;
+	pool->journalSize = 0;
+}
+
+// Removes a block that has run out of colors from its parent, which must exist. If that leaves the parent with only one
+// child, the parent is replaced by that child. Returns the lowest octant whose bounds might have changed.
+ColorPoolOctant* removeEmptyBlockFromTree(RB_ColorPool* pool, ColorPoolBlock* block) {
+	ColorPoolOctant* octant = block->parentData.octant;
+	NodeChildrenSize removedIndex = block->parentData.index;
+
+	recordPoolMutation(pool, &(octant->numChildren), sizeof(octant->numChildren));
 	octant->numChildren--;
-	octant->children[colorNode->parentData.index] = octant->children[octant->numChildren];
-	updateNodeParentData(octant->children[colorNode->parentData.index], octant, colorNode->parentData.index);
+	recordPoolMutation(pool, &(octant->children[removedIndex]), sizeof(ColorPoolNode));
+	octant->children[removedIndex] = octant->children[octant->numChildren];
+	setNodeParentDataRecorded(pool, octant->children[removedIndex], octant, removedIndex);
 
 	// if the parent now only has one node, replace it with its one node.
 	if(octant->numChildren == 1) {
 		if(octant->parentData.octant == NULL) {
 			// If the octant is the root node, replace the root node.
+			recordPoolMutation(pool, &(pool->root), sizeof(pool->root));
 			pool->root = octant->children[0];
 		} else {
-			octant->parentData.octant->children[octant->parentData.index] = octant->children[0];
+			ColorPoolNode* slot = &(octant->parentData.octant->children[octant->parentData.index]);
+			recordPoolMutation(pool, slot, sizeof(ColorPoolNode));
+			*slot = octant->children[0];
 		}
-		updateNodeParentData(octant->children[0], octant->parentData.octant, octant->parentData.index);
+		setNodeParentDataRecorded(pool, octant->children[0], octant->parentData.octant, octant->parentData.index);
 
 		// This octant no longer exists. Advance to its parent octant.
 		octant = octant->parentData.octant;
 	}
 
+	return octant;
+}
+
+bool RB_removeColorFromPool(RB_ColorPool* pool, RB_Color toRemove) {
+	ColorPoolColorNode* colorNode = findColorNode(pool, toRemove);
+
+	// If colorNode doesn't exist or has already been used up, it can't be removed.
+	if(colorNode == NULL || colorNode->remaining == 0) {
+		return false;
+	}
+
+	ColorPoolBlock* block = findBlock(
+		pool,
+		toRemove.r >> RB_COLOR_POOL_BLOCK_SHIFT,
+		toRemove.g >> RB_COLOR_POOL_BLOCK_SHIFT,
+		toRemove.b >> RB_COLOR_POOL_BLOCK_SHIFT
+	);
+
+	/*
+	Every write below is recorded first, so that RB_poolRollback can undo it. Room for all of them is reserved up front,
+	so a removal is either recorded completely or not made at all. The block and its color take at most 8 entries:
+	remaining, numAvailable and availableMask, then either its two corners or the (at most 5) writes of taking it out
+	of the tree. Each ancestor takes at most 4: numAvailable, its two corners and its representative.
+	*/
+	if(pool->isJournaling) {
+		RB_Size depth = 0;
+		for(ColorPoolOctant* ancestor = block->parentData.octant; ancestor != NULL; ancestor = ancestor->parentData.octant) {
+			depth++;
+		}
+
+		if(!reservePoolJournal(pool, 8 + 4 * depth)) {
+			fprintf(stderr, "Error removing color from pool: could not grow the journal!\n");
+			return false;
+		}
+	}
+
+	recordPoolMutation(pool, &(colorNode->remaining), sizeof(colorNode->remaining));
+	colorNode->remaining--;
+
+	recordPoolMutation(pool, &(block->numAvailable), sizeof(block->numAvailable));
+	block->numAvailable--;
+
+	for(ColorPoolOctant* ancestor = block->parentData.octant; ancestor != NULL; ancestor = ancestor->parentData.octant) {
+		recordPoolMutation(pool, &(ancestor->numAvailable), sizeof(ancestor->numAvailable));
+		ancestor->numAvailable--;
+	}
+
+	// The color can still be used, so it stays in the tree.
+	if(colorNode->remaining > 0) {
+		return true;
+	}
+
+	recordPoolMutation(pool, &(block->availableMask), sizeof(block->availableMask));
+	block->availableMask &= ~(((uint64_t) 1) << getBlockBitIndex(toRemove));
+
+	ColorPoolOctant* octant = block->parentData.octant;
+	ColorPoolOctant* formerParent = octant;
+
+	if(block->availableMask != 0) {
+		// The block stays in the tree, but its bounds might have shrunk.
+		RB_Color newMinCorner;
+		RB_Color newMaxCorner;
+		calculateBlockCorners(block, &newMinCorner, &newMaxCorner);
+
+		if(RB_colorsAreEqual(block->minCorner, newMinCorner) && RB_colorsAreEqual(block->maxCorner, newMaxCorner)) {
+			// Neither will any octant's.
+			octant = NULL;
+		} else {
+			recordPoolMutation(pool, &(block->minCorner), sizeof(block->minCorner));
+			block->minCorner = newMinCorner;
+			recordPoolMutation(pool, &(block->maxCorner), sizeof(block->maxCorner));
+			block->maxCorner = newMaxCorner;
+		}
+	} else if(octant == NULL) {
+		// If the block has no parent, then it is presumably the root. Set the root to empty and return.
+		printf("Removing last color from the pool.\n");
+		recordPoolMutation(pool, &(pool->root), sizeof(pool->root));
+		pool->root = emptyColorPoolNode;
+		return true;
+	} else {
+		octant = removeEmptyBlockFromTree(pool, block);
+	}
+
 	// Update the bounds of the ancestor octants.
 	while(octant != NULL) {
-		RB_Color oldMinCorner = octant->minCorner;
-		RB_Color oldMaxCorner = octant->maxCorner;
-
-		octant->minCorner = calculateOctantMinCorner(octant);
-		octant->maxCorner = calculateOctantMaxCorner(octant);
+		RB_Color newMinCorner = calculateOctantMinCorner(octant);
+		RB_Color newMaxCorner = calculateOctantMaxCorner(octant);
 
 		// If the bounds do not change, they won't change for the parent, either. The updating-bounds phase is over.
-		if(RB_colorsAreEqual(octant->minCorner, oldMinCorner) && RB_colorsAreEqual(octant->maxCorner, oldMaxCorner)) {
+		if(RB_colorsAreEqual(octant->minCorner, newMinCorner) && RB_colorsAreEqual(octant->maxCorner, newMaxCorner)) {
 			break;
 		}
 
+		recordPoolMutation(pool, &(octant->minCorner), sizeof(octant->minCorner));
+		octant->minCorner = newMinCorner;
+		recordPoolMutation(pool, &(octant->maxCorner), sizeof(octant->maxCorner));
+		octant->maxCorner = newMaxCorner;
+
 		octant = octant->parentData.octant;
 	}
 
+	// Every ancestor that was represented by the removed color needs a new representative. An octant's representative
+	// always comes from one of its children, so these ancestors form an unbroken chain starting at the block's former
+	// parent. If the former parent was collapsed, its remaining child is still in children[0] and it still links to
+	// its parent.
+	for(octant = formerParent; octant != NULL && octant->representative == colorNode; octant = octant->parentData.octant) {
+		recordPoolMutation(pool, &(octant->representative), sizeof(octant->representative));
+		octant->representative = getNodeRepresentative(octant->children[0]);
+	}
+
 	return true;
 }
 
+void RB_setColorPoolExpansionCounting(RB_ColorPool* pool, bool countExpansions) {
+	pool->countsExpansions = countExpansions;
+}
+
+/*
+Writes a summary of the tree to the stream as JSON, one entry per level, so that it can be loaded into the
+OctantTreeGeneration visualizer. Each level records how many octants and blocks it has, the histogram of its octants'
+child counts, and the number of available colors and search expansions under it. Levels no deeper than
+maxDetailedDepth also list every octant as [minR, minG, minB, maxR, maxG, maxB, numChildren, numAvailable,
+numExpansions]; pass -1 to only write the totals.
+The walk is breadth-first, one level at a time, using the node queue for the current level.
+*/
+bool RB_exportColorPoolTree(RB_ColorPool* pool, FILE* stream, int maxDetailedDepth) {
+	ColorPoolNode* levelNodes = pool->nodeQueue;
+	ColorPoolNode* nextLevelNodes = (ColorPoolNode*) malloc(sizeof(ColorPoolNode) * pool->numBlocks);
+
+	if(nextLevelNodes == NULL) {
+		fprintf(stderr, "Error exporting color pool tree: malloc failed!\n");
+		return false;
+	}
+
+	RB_Size numLevelNodes = 0;
+	RB_Size totalAvailable = 0;
+	RB_Color rootMin = { .r = 0, .g = 0, .b = 0 };
+	RB_Color rootMax = rootMin;
+
+	if(pool->root.type != POOL_NODE_EMPTY) {
+		levelNodes[0] = pool->root;
+		numLevelNodes = 1;
+		totalAvailable = getNodeAvailableCount(pool->root);
+		rootMin = getNodeMinCorner(pool->root);
+		rootMax = getNodeMaxCorner(pool->root);
+	}
+
+	fprintf(
+		stream,
+		"{\n\t\"numAvailable\": %ld,\n\t\"minCorner\": [%d, %d, %d],\n\t\"maxCorner\": [%d, %d, %d],\n\t\"levels\": [",
+		(long) totalAvailable,
+		rootMin.r, rootMin.g, rootMin.b,
+		rootMax.r, rootMax.g, rootMax.b
+	);
+
+	for(int depth = 0; numLevelNodes > 0; depth++) {
+		RB_Size numOctants = 0;
+		RB_Size numBlocks = 0;
+		RB_Size numAvailable = 0;
+		uint_fast64_t numExpansions = 0;
+		RB_Size childCounts[RB_COLOR_POOL_NODE_NUM_CHILDREN + 1] = {0};
+
+		for(RB_Size i = 0; i < numLevelNodes; i++) {
+			numAvailable += getNodeAvailableCount(levelNodes[i]);
+
+			if(levelNodes[i].type == POOL_NODE_BLOCK) {
+				numBlocks++;
+				continue;
+			}
+
+			ColorPoolOctant* octant = levelNodes[i].octantNodePtr;
+			numOctants++;
+			numExpansions += octant->numExpansions;
+			childCounts[octant->numChildren]++;
+		}
+
+		fprintf(
+			stream,
+			"%s\n\t\t{\n\t\t\t\"depth\": %d,\n\t\t\t\"numOctants\": %ld,\n\t\t\t\"numBlocks\": %ld,\n"
+			"\t\t\t\"numAvailable\": %ld,\n\t\t\t\"numExpansions\": %lu,\n\t\t\t\"childCounts\": [",
+			(depth == 0)? "" : ",",
+			depth, (long) numOctants, (long) numBlocks, (long) numAvailable, (unsigned long) numExpansions
+		);
+		for(int i = 0; i <= RB_COLOR_POOL_NODE_NUM_CHILDREN; i++) {
+			fprintf(stream, (i == 0)? "%ld" : ", %ld", (long) childCounts[i]);
+		}
+		fprintf(stream, "]");
+
+		if(depth <= maxDetailedDepth) {
+			fprintf(stream, ",\n\t\t\t\"octants\": [");
+			bool isFirst = true;
+
+			for(RB_Size i = 0; i < numLevelNodes; i++) {
+				if(levelNodes[i].type != POOL_NODE_OCTANT) {
+					continue;
+				}
+
+				ColorPoolOctant* octant = levelNodes[i].octantNodePtr;
+				fprintf(
+					stream,
+					"%s\n\t\t\t\t[%d, %d, %d, %d, %d, %d, %d, %ld, %lu]",
+					isFirst? "" : ",",
+					octant->minCorner.r, octant->minCorner.g, octant->minCorner.b,
+					octant->maxCorner.r, octant->maxCorner.g, octant->maxCorner.b,
+					(int) octant->numChildren, (long) octant->numAvailable, (unsigned long) octant->numExpansions
+				);
+				isFirst = false;
+			}
+
+			fprintf(stream, "\n\t\t\t]");
+		}
+
+		fprintf(stream, "\n\t\t}");
+
+		// Gather the next level. A level never has more nodes than there are blocks, so the arrays are big enough.
+		RB_Size numNextLevelNodes = 0;
+		for(RB_Size i = 0; i < numLevelNodes; i++) {
+			if(levelNodes[i].type != POOL_NODE_OCTANT) {
+				continue;
+			}
+
+			ColorPoolOctant* octant = levelNodes[i].octantNodePtr;
+			for(NodeChildrenSize j = 0; j < octant->numChildren; j++) {
+				nextLevelNodes[numNextLevelNodes] = octant->children[j];
+				numNextLevelNodes++;
+			}
+		}
+
+		ColorPoolNode* swap = levelNodes;
+		levelNodes = nextLevelNodes;
+		nextLevelNodes = swap;
+		numLevelNodes = numNextLevelNodes;
+	}
+
+	fprintf(stream, "\n\t]\n}\n");
+
+	// One of the two arrays is the node queue, which belongs to the pool.
+	free((nextLevelNodes == pool->nodeQueue)? levelNodes : nextLevelNodes);
+
+	return !ferror(stream);
+}
+
 void printNode(FILE* stream, ColorPoolNode node) {
 	switch(node.type) {
 		case POOL_NODE_EMPTY:
@@ -713,6 +2920,21 @@ void printNode(FILE* stream, ColorPoolNode node) {
 			fprintf(stream, "Color Node(%u,%u,%u)", col.r, col.g, col.b);
 			break;
 		}
+		case POOL_NODE_BLOCK: {
+			ColorPoolBlock* block = node.blockNodePtr;
+			fprintf(
+				stream,
+				"Block Node(%d colors) min = (%u,%u,%u) max = (%u,%u,%u)",
+				__builtin_popcountll(block->availableMask),
+				block->minCorner.r,
+				block->minCorner.g,
+				block->minCorner.b,
+				block->maxCorner.r,
+				block->maxCorner.g,
+				block->maxCorner.b
+			);
+			break;
+		}
 		case POOL_NODE_OCTANT: {
 			ColorPoolOctant* oct = node.octantNodePtr;
 			fprintf(
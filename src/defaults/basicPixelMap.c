@@ -2,32 +2,45 @@
 #include "headers/RB_AssignmentQueue.h"
 #include <stdlib.h>
 #include <stdio.h>
-
-// Added for the random unset pixel experiment
 #include "headers/RB_Main.h"
 
+// RB_determinePreferredCoordColor averages the set pixels within this many steps of the coord, counting diagonal steps
+// as one. The window sums below only have room for a radius of up to 3.
+#define RB_PREFERRED_COLOR_RADIUS 1
+
 struct RB_PixelMap_s {
-	RB_Pixel** pixels;
+	// Indexed by pixel index.
+	RB_Pixel* pixels;
 	RB_Size width;
 	RB_Size height;
 
-	// Added for the random unset pixel experiment
-	RB_Coord* unsetCoords;
-	RB_Size* coordIndexes;
-	RB_Size numUnsetCoords;
-
 	int rRes;
 	int gRes;
 	int bRes;
+
+	// Bitboards of the pixels that are set and the coords this map has added to the queue. Bit (x % 64) of word
+	// (y * wordsPerRow) + (x / 64) is the pixel at (x, y). Bits past the right edge are always 0. A coord only leaves the
+	// queue by being set, so a queued bit stays on until its pixel is set.
+	uint64_t* setRows;
+	uint64_t* queuedRows;
+	// Pixels that are held back from the queue until RB_releaseReservedPixels is called.
+	uint64_t* reservedRows;
+	RB_Size numReservedPixels;
+	RB_Size wordsPerRow;
+
+	// The sums of the colors of the set pixels in each coord's window, and how many there are, indexed by pixel index.
+	// They're updated whenever a pixel is set, so looking up a preferred color never has to scan the window. Each is
+	// its own array so that a row of a window is one contiguous run in each of them. A window holds at most 49 pixels,
+	// and 49 * 255 fits in 16 bits.
+	uint16_t* windowRSums;
+	uint16_t* windowGSums;
+	uint16_t* windowBSums;
+	uint8_t* windowCounts;
 };
 
 // allocates a pixel map with the specified dimensions
 RB_PixelMap* RB_createPixelMap(RB_Size width, RB_Size height, int rRes, int gRes, int bRes) {
-	RB_PixelMap* ret = (RB_PixelMap*) malloc(
-		sizeof(RB_PixelMap)
-		+ (sizeof(RB_Pixel*) * width)
-		+ (sizeof(RB_Pixel) * width * height)
-	);
+	RB_PixelMap* ret = (RB_PixelMap*) malloc(sizeof(RB_PixelMap) + (sizeof(RB_Pixel) * width * height));
 
 	if(ret == NULL) {
 		return NULL;
@@ -39,44 +52,56 @@ RB_PixelMap* RB_createPixelMap(RB_Size width, RB_Size height, int rRes, int gRes
 	ret->gRes = gRes;
 	ret->bRes = bRes;
 
-	ret->pixels = (RB_Pixel**) (ret + 1);
-	RB_Pixel* pixelData = (RB_Pixel*) (ret->pixels + width);
+	ret->pixels = (RB_Pixel*) (ret + 1);
 
-	for(int x = 0; x < width; x++) {
-		ret->pixels[x] = pixelData + (x * height);
-
-		for(int y = 0; y < height; y++) {
-			ret->pixels[x][y] = (RB_Pixel) {
-				.loc = { .x = x, .y = y },
-				.color = { .r = 0, .g = 0, .b = 0 },
-				.status = RB_PIXEL_BLANK
-			};
-		}
+	for(RB_Size i = 0; i < width * height; i++) {
+		ret->pixels[i] = (RB_Pixel) {
+			.color = { .r = 0, .g = 0, .b = 0 },
+			.status = RB_PIXEL_BLANK
+		};
 	}
 
-	// Added for the random unset pixel experiment
-	ret->unsetCoords = malloc(sizeof(RB_Coord) * width * height);
-	ret->coordIndexes = malloc(sizeof(RB_Size) * width * height);
-	if(ret->unsetCoords == NULL || ret->coordIndexes == NULL) {
+	ret->wordsPerRow = (width + 63) / 64;
+	ret->setRows = (uint64_t*) calloc(ret->wordsPerRow * height, sizeof(uint64_t));
+	ret->queuedRows = (uint64_t*) calloc(ret->wordsPerRow * height, sizeof(uint64_t));
+	ret->reservedRows = (uint64_t*) calloc(ret->wordsPerRow * height, sizeof(uint64_t));
+	ret->numReservedPixels = 0;
+	ret->windowRSums = (uint16_t*) calloc(width * height, sizeof(uint16_t));
+	ret->windowGSums = (uint16_t*) calloc(width * height, sizeof(uint16_t));
+	ret->windowBSums = (uint16_t*) calloc(width * height, sizeof(uint16_t));
+	ret->windowCounts = (uint8_t*) calloc(width * height, sizeof(uint8_t));
+	if(
+		ret->setRows == NULL || ret->queuedRows == NULL || ret->reservedRows == NULL
+		|| ret->windowRSums == NULL || ret->windowGSums == NULL || ret->windowBSums == NULL || ret->windowCounts == NULL
+	) {
+		free(ret->setRows);
+		free(ret->queuedRows);
+		free(ret->reservedRows);
+		free(ret->windowRSums);
+		free(ret->windowGSums);
+		free(ret->windowBSums);
+		free(ret->windowCounts);
+		free(ret);
 		return NULL;
 	}
-	ret->numUnsetCoords = width * height;
-	for(RB_Size x = 0; x < width; x++) {
-		for(RB_Size y = 0; y < height; y++) {
-			RB_Size index = (x * height) + y;
-			ret->unsetCoords[index] = (RB_Coord) { .x = x, .y = y };
-			ret->coordIndexes[index] = index;
-		}
-	}
 
 	return ret;
 }
 
 // deallocates the pixel map
 void RB_freePixelMap(RB_PixelMap* map) {
+	if(map == NULL) {
+		return;
+	}
+
 	printf("Freeing RB_PixelMap!\n");
-	free(map->unsetCoords);
-	free(map->coordIndexes);
+	free(map->setRows);
+	free(map->queuedRows);
+	free(map->reservedRows);
+	free(map->windowRSums);
+	free(map->windowGSums);
+	free(map->windowBSums);
+	free(map->windowCounts);
 	free(map);
 }
 
@@ -101,13 +126,13 @@ RB_Pixel* RB_getPixel(RB_PixelMap* map, RB_Coord coord) {
 		return NULL;
 	}
 
-	return &(map->pixels[coord.x][coord.y]);
+	return &(map->pixels[RB_getPixelIndex(coord, map->width)]);
 }
 
 // Determines, based on the current state of the pixelMap, the preferred color for the specified coordinate.
 RB_Color RB_determinePreferredCoordColor(RB_PixelMap* pixelMap, RB_Coord coord) {
-	const static RB_Size numCols = 1;
-	const static RB_Size numRows = 1;
+	enum { numCols = 1 };
+	enum { numRows = 1 };
 	static RB_Color cMap[numCols][numRows] = {0};
 	RB_Coord cellSize = {
 		(pixelMap->width + 1) / numCols,
@@ -127,46 +152,15 @@ RB_Color RB_determinePreferredCoordColor(RB_PixelMap* pixelMap, RB_Coord coord)
 	const static int gridType = 0;
 	const static int randomUnset = 0;
 	const static int gridCircleRadius = 2;
-	const RB_Size searchRadius = 1;
-	
-	//const RB_Size searchRadius = ((gridCell.x >= 5 && gridCell.x <= 6) || (gridCell.y >= 5 && gridCell.y <= 6))? 2 : 1;
-	RB_Size minX = ((coord.x - searchRadius) < 0)? 0 : coord.x - searchRadius;
-	RB_Size maxX = ((coord.x + searchRadius) >= pixelMap->width)? pixelMap->width - 1 : coord.x + searchRadius;
-	RB_Size minY = ((coord.y - searchRadius) < 0)? 0 : coord.y - searchRadius;
-	RB_Size maxY = ((coord.y + searchRadius) >= pixelMap->height)? pixelMap->height - 1 : coord.y + searchRadius;
-
-	RB_Size rSum = 0;
-	RB_Size gSum = 0;
-	RB_Size bSum = 0;
-
-	uint_fast32_t numNeighbors = 0;
 
-	
-	for(RB_Size x = minX; x <= maxX; x++) {
-		for(RB_Size y = minY; y <= maxY; y++) {
-			RB_Coord newCoord = { .x = x, .y = y };
-
-			RB_Pixel* neighborPixel = RB_getPixel(pixelMap, newCoord);
-
-			if(neighborPixel == NULL) {
-				fprintf(stderr,
-					"Somehow, determinePreferredCoordColor has encountered a NULL pixel"
-					"even though that shouldn't be possible?\nThe pixel is at %d %d.\n",
-					x, y
-				);
-				continue;
-			}
+	// The sums of the set pixels within RB_PREFERRED_COLOR_RADIUS are kept up to date as pixels are set.
+	RB_PixelIndex pixel = RB_getPixelIndex(coord, pixelMap->width);
+	RB_Size rSum = pixelMap->windowRSums[pixel];
+	RB_Size gSum = pixelMap->windowGSums[pixel];
+	RB_Size bSum = pixelMap->windowBSums[pixel];
 
-			if(neighborPixel->status != RB_PIXEL_SET) continue;
+	uint_fast32_t numNeighbors = pixelMap->windowCounts[pixel];
 
-			numNeighbors++;
-			rSum += neighborPixel->color.r;
-			gSum += neighborPixel->color.g;
-			bSum += neighborPixel->color.b;
-
-		}
-	}
-	
 
 	int rRes = pixelMap->rRes;
 	int gRes = pixelMap->gRes;
@@ -245,59 +239,303 @@ RB_Color RB_determinePreferredCoordColor(RB_PixelMap* pixelMap, RB_Coord coord)
 }
 
 
+uint64_t* getBitboardWord(RB_PixelMap* map, uint64_t* rows, RB_Coord coord) {
+	return rows + (coord.y * map->wordsPerRow) + (coord.x >> 6);
+}
+
+void setBitboardBit(RB_PixelMap* map, uint64_t* rows, RB_Coord coord) {
+	*getBitboardWord(map, rows, coord) |= ((uint64_t) 1) << (coord.x & 63);
+}
+
+void clearBitboardBit(RB_PixelMap* map, uint64_t* rows, RB_Coord coord) {
+	*getBitboardWord(map, rows, coord) &= ~(((uint64_t) 1) << (coord.x & 63));
+}
+
+// Returns the 64 bits of the row starting at x, which can be -1. Bits outside the map are 0.
+uint64_t getBitboardBits(RB_PixelMap* map, uint64_t* rows, RB_Size y, RB_Size x) {
+	if(y < 0 || y >= map->height) {
+		return 0;
+	}
+
+	uint64_t* row = rows + (y * map->wordsPerRow);
+	RB_Size word = (x < 0)? -1 : x >> 6;
+	int offset = x & 63;
+
+	uint64_t low = (word >= 0)? row[word] : 0;
+	uint64_t high = (word + 1 < map->wordsPerRow)? row[word + 1] : 0;
+
+	return (offset == 0)? low : (low >> offset) | (high << (64 - offset));
+}
+
+// The number of set pixels in the 3x3 block centered on the coord.
+int countSetPixelsAround(RB_PixelMap* map, RB_Coord coord) {
+	return __builtin_popcountll(
+		((getBitboardBits(map, map->setRows, coord.y - 1, coord.x - 1) & 7) << 6)
+		| ((getBitboardBits(map, map->setRows, coord.y, coord.x - 1) & 7) << 3)
+		| (getBitboardBits(map, map->setRows, coord.y + 1, coord.x - 1) & 7)
+	);
+}
+
+int RB_countSetPixelsAround(RB_PixelMap* map, RB_Coord coord) {
+	return countSetPixelsAround(map, coord);
+}
+
+/*
+The weight a blank coord gets in a weighted queue. It doubles with every set neighbour, so a coord that's almost
+surrounded is picked long before the ones on the open edge of the frontier, and single-pixel holes get filled while
+their neighbours' colors are still available nearby.
+*/
+uint32_t getSetNeighborWeight(RB_PixelMap* map, RB_Coord coord) {
+	return ((uint32_t) 1) << countSetPixelsAround(map, coord);
+}
+
+// Queues the blank coords in toQueue, which are bits of row y starting at x. In a weighted queue, also updates the
+// weight of the blank coords in toWeigh, which must include toQueue.
+void queueBitboardBits(RB_PixelMap* map, RB_AssignmentQueue* queue, RB_Size y, RB_Size x, uint64_t toQueue, uint64_t toWeigh) {
+	while(toQueue != 0) {
+		RB_Coord coord = { .x = x + __builtin_ctzll(toQueue), .y = y };
+		toQueue &= toQueue - 1;
+
+		RB_addCoordToAssignmentQueue(queue, coord, -1);
+		setBitboardBit(map, map->queuedRows, coord);
+	}
+
+	if(RB_getAssignmentQueueSampling(queue) != RB_QUEUE_SAMPLING_WEIGHTED) {
+		return;
+	}
+
+	while(toWeigh != 0) {
+		RB_Coord coord = { .x = x + __builtin_ctzll(toWeigh), .y = y };
+		toWeigh &= toWeigh - 1;
+
+		if(RB_coordIsInQueue(queue, coord)) {
+			RB_setCoordWeightInAssignmentQueue(queue, coord, getSetNeighborWeight(map, coord));
+		}
+	}
+}
+
+/*
+Adds the newly set pixel's color to the window sums of every coord within RB_PREFERRED_COLOR_RADIUS of it. The coords
+in a row of the window are next to each other in every array, so each row is a run of independent adds that the
+compiler can vectorize.
+*/
+void addPixelToWindowSums(RB_PixelMap* map, RB_Coord coord, RB_Color color) {
+	RB_Size minX = (coord.x - RB_PREFERRED_COLOR_RADIUS < 0)? 0 : coord.x - RB_PREFERRED_COLOR_RADIUS;
+	RB_Size maxX = (coord.x + RB_PREFERRED_COLOR_RADIUS >= map->width)? map->width - 1 : coord.x + RB_PREFERRED_COLOR_RADIUS;
+	RB_Size minY = (coord.y - RB_PREFERRED_COLOR_RADIUS < 0)? 0 : coord.y - RB_PREFERRED_COLOR_RADIUS;
+	RB_Size maxY = (coord.y + RB_PREFERRED_COLOR_RADIUS >= map->height)? map->height - 1 : coord.y + RB_PREFERRED_COLOR_RADIUS;
+
+	uint16_t r = color.r;
+	uint16_t g = color.g;
+	uint16_t b = color.b;
+
+	for(RB_Size y = minY; y <= maxY; y++) {
+		RB_Size rowStart = (y * map->width) + minX;
+		RB_Size rowLength = maxX - minX + 1;
+
+		uint16_t* rRow = map->windowRSums + rowStart;
+		uint16_t* gRow = map->windowGSums + rowStart;
+		uint16_t* bRow = map->windowBSums + rowStart;
+		uint8_t* countRow = map->windowCounts + rowStart;
+
+		for(RB_Size i = 0; i < rowLength; i++) {
+			rRow[i] += r;
+			gRow[i] += g;
+			bRow[i] += b;
+			countRow[i]++;
+		}
+	}
+}
+
+// Marks the coord as set in the bitboards and the window sums. It's no longer queued, since it's been assigned, and if
+// it was reserved, it has been set anyway, so there's nothing left to release. Marking a pixel twice does nothing.
+void markPixelSet(RB_PixelMap* map, RB_Coord coord) {
+	uint64_t bit = ((uint64_t) 1) << (coord.x & 63);
+	uint64_t* reservedWord = getBitboardWord(map, map->reservedRows, coord);
+
+	if(*getBitboardWord(map, map->setRows, coord) & bit) {
+		return;
+	}
+
+	addPixelToWindowSums(map, coord, map->pixels[RB_getPixelIndex(coord, map->width)].color);
+
+	if(*reservedWord & bit) {
+		*reservedWord &= ~bit;
+		map->numReservedPixels--;
+	}
+
+	setBitboardBit(map, map->setRows, coord);
+	clearBitboardBit(map, map->queuedRows, coord);
+}
+
 // Add cords to the queue in an implementation-defined pattern relative to the given coord
 void RB_addResultantCoordsToQueue(RB_PixelMap* map, RB_AssignmentQueue* queue, RB_Coord center) {
-	// Added for the random unset pixel experiment
-	//RB_Size coordIndex = map->coordIndexes[(center.x * map->height) + center.y];
-	// RB_Coord lastCoord = map->unsetCoords[map->numUnsetCoords - 1];
-	// map->unsetCoords[coordIndex] = lastCoord;
-	// map->coordIndexes[(center.x * map->height) + center.y] = -1;
-	// map->coordIndexes[(lastCoord.x * map->height) + lastCoord.y] = coordIndex;
-	// map->numUnsetCoords--;
-
-	// static RB_Coord lastRandomCoord = { -1, -1 };
-
-	// if(map->numUnsetCoords > 0) {
-	// 	RB_Pixel* lastCoordPixel = RB_getPixel(map, lastRandomCoord);
-
-	// 	if(
-	// 		lastCoordPixel == NULL
-	// 		|| lastCoordPixel->status != RB_PIXEL_BLANK
-	// 	) {
-	// 		RB_Coord coordToAdd = map->unsetCoords[rand() % map->numUnsetCoords];
-	// 		RB_Pixel* toAdd = RB_getPixel(map, coordToAdd);
-	// 		RB_addCoordToAssignmentQueue(queue, toAdd->loc, -1);
-	// 		lastRandomCoord = coordToAdd;
-	// 	}
-	// }
+	markPixelSet(map, center);
 
+	// The center's 3x3 block is three bits in each of three rows. Clip the bits that fall outside the map.
+	uint64_t inBounds = 7;
+	if(center.x == 0) inBounds &= ~((uint64_t) 1);
+	if(center.x == map->width - 1) inBounds &= ~((uint64_t) 4);
 
-	// if(map->numUnsetCoords > 0) {
-	// 	RB_Coord coordToAdd = map->unsetCoords[rand() % map->numUnsetCoords];
-	// 	RB_Pixel* toAdd = RB_getPixel(map, coordToAdd);
-	// 	RB_addCoordToAssignmentQueue(queue, toAdd->loc, -1);
-	// }
+	for(RB_Size y = center.y - 1; y <= center.y + 1; y++) {
+		if(y < 0 || y >= map->height) continue;
 
+		uint64_t blank = inBounds & ~getBitboardBits(map, map->setRows, y, center.x - 1);
+		uint64_t unqueued = blank
+			& ~getBitboardBits(map, map->queuedRows, y, center.x - 1)
+			& ~getBitboardBits(map, map->reservedRows, y, center.x - 1);
 
+		// Setting the center gave every blank coord around it another set neighbour, so they're all worth more now.
+		queueBitboardBits(map, queue, y, center.x - 1, unqueued, blank);
+	}
+}
 
-	
-	int addRadius = 1;
+void RB_moveQueuedCoords(RB_PixelMap* map, RB_AssignmentQueue* from, RB_AssignmentQueue* to) {
+	bool weighted = RB_getAssignmentQueueSampling(to) == RB_QUEUE_SAMPLING_WEIGHTED;
 
-	for(RB_Size dx = -addRadius; dx <= addRadius; dx++) {
-		for(RB_Size dy = -addRadius; dy <= addRadius; dy++) {
-			if(dx == 0 && dy == 0) continue;
+	while(!RB_isQueueEmpty(from)) {
+		RB_Coord coord = RB_chooseCoordFromAssignmentQueue(from);
+		RB_removeCoordFromAssignmentQueue(from, coord);
+		RB_addCoordToAssignmentQueue(to, coord, -1);
 
-			// if(dy <= 0 && dx != 0) continue;
+		if(weighted) {
+			RB_setCoordWeightInAssignmentQueue(to, coord, getSetNeighborWeight(map, coord));
+		}
+	}
+}
 
-			// if(dx * dx == dy * dy) {
-			// 	continue;
-			// }
+// The bits of row y's word that are set, or next to a set pixel in the rows above and below, shifted up and down by
+// one so the columns to either side are included. The word's neighbours supply the bits that shift across its edges.
+uint64_t getDilatedSetWord(RB_PixelMap* map, RB_Size y, RB_Size word) {
+	uint64_t columns[3] = { 0, 0, 0 };
 
-			RB_Pixel* toAdd = RB_getPixel(map, (RB_Coord) { .x = center.x + dx, .y = center.y + dy });
-			if(toAdd == NULL) continue;
-			if(toAdd->status != RB_PIXEL_BLANK) continue;
+	for(RB_Size dy = -1; dy <= 1; dy++) {
+		if(y + dy < 0 || y + dy >= map->height) continue;
 
-			RB_addCoordToAssignmentQueue(queue, toAdd->loc, -1);
+		uint64_t* row = map->setRows + ((y + dy) * map->wordsPerRow);
+		for(int i = 0; i < 3; i++) {
+			RB_Size w = word + i - 1;
+			if(w >= 0 && w < map->wordsPerRow) {
+				columns[i] |= row[w];
+			}
 		}
 	}
-}
\ No newline at end of file
+
+	uint64_t ret = columns[1] | (columns[1] << 1) | (columns[1] >> 1) | (columns[0] >> 63) | (columns[2] << 63);
+
+	// Keep the bits past the right edge clear.
+	if(word == map->wordsPerRow - 1 && (map->width & 63) != 0) {
+		ret &= (((uint64_t) 1) << (map->width & 63)) - 1;
+	}
+
+	return ret;
+}
+
+// Queues every blank, unreserved coord next to a set pixel in rows minY to maxY and words minWord to maxWord.
+void queueFrontierInBox(RB_PixelMap* map, RB_AssignmentQueue* queue, RB_Size minY, RB_Size maxY, RB_Size minWord, RB_Size maxWord) {
+	for(RB_Size y = minY; y <= maxY; y++) {
+		for(RB_Size word = minWord; word <= maxWord; word++) {
+			RB_Size index = (y * map->wordsPerRow) + word;
+			uint64_t blank = getDilatedSetWord(map, y, word) & ~map->setRows[index];
+			uint64_t unqueued = blank & ~map->queuedRows[index] & ~map->reservedRows[index];
+
+			queueBitboardBits(map, queue, y, word * 64, unqueued, blank);
+		}
+	}
+}
+
+/*
+Like RB_addResultantCoordsToQueue for many centers at once, which is much faster for seeding. The centers are marked
+as set first, and then the frontier around all of them is found a word at a time: a coord is queued if it's blank
+and next to any set pixel.
+*/
+void RB_addResultantCoordsOfBatchToQueue(RB_PixelMap* map, RB_AssignmentQueue* queue, const RB_Coord* centers, RB_Size numCenters) {
+	if(numCenters == 0) {
+		return;
+	}
+
+	RB_Coord min = centers[0];
+	RB_Coord max = centers[0];
+
+	for(RB_Size i = 0; i < numCenters; i++) {
+		markPixelSet(map, centers[i]);
+
+		if(centers[i].x < min.x) min.x = centers[i].x;
+		if(centers[i].y < min.y) min.y = centers[i].y;
+		if(centers[i].x > max.x) max.x = centers[i].x;
+		if(centers[i].y > max.y) max.y = centers[i].y;
+	}
+
+	RB_Size minY = (min.y > 0)? min.y - 1 : 0;
+	RB_Size maxY = (max.y < map->height - 1)? max.y + 1 : map->height - 1;
+	RB_Size minWord = (min.x > 0)? (min.x - 1) >> 6 : 0;
+	RB_Size maxWord = (max.x < map->width - 1)? (max.x + 1) >> 6 : map->wordsPerRow - 1;
+
+	queueFrontierInBox(map, queue, minY, maxY, minWord, maxWord);
+}
+/*
+Reserves about `fraction` of the pixels with a jittered grid: the map is cut into cells of at most 1 / fraction pixels,
+and one random pixel in each cell is reserved with probability (fraction * the cell's area). Unlike picking pixels
+independently, this never leaves clumps of reserved pixels or large areas without any. Cells cut off by the edge of
+the map are smaller, so they're less likely to get one, which keeps the density even.
+*/
+void RB_reservePixels(RB_PixelMap* map, double fraction) {
+	if(fraction <= 0) {
+		return;
+	}
+
+	// The cells are as close to square as their area allows.
+	RB_Size maxCellArea = (RB_Size) (1.0 / fraction);
+	RB_Size cellWidth = 1;
+	while((cellWidth + 1) * (cellWidth + 1) <= maxCellArea) {
+		cellWidth++;
+	}
+	RB_Size cellHeight = maxCellArea / cellWidth;
+
+	for(RB_Size cellY = 0; cellY < map->height; cellY += cellHeight) {
+		for(RB_Size cellX = 0; cellX < map->width; cellX += cellWidth) {
+			RB_Size width = (cellX + cellWidth <= map->width)? cellWidth : map->width - cellX;
+			RB_Size height = (cellY + cellHeight <= map->height)? cellHeight : map->height - cellY;
+
+			if(rand() >= fraction * width * height * ((double) RAND_MAX + 1)) {
+				continue;
+			}
+
+			RB_Coord coord = {
+				.x = cellX + (((RB_Size) rand()) % width),
+				.y = cellY + (((RB_Size) rand()) % height)
+			};
+
+			uint64_t bit = ((uint64_t) 1) << (coord.x & 63);
+			uint64_t* reservedWord = getBitboardWord(map, map->reservedRows, coord);
+
+			if(!(*getBitboardWord(map, map->setRows, coord) & bit) && !(*reservedWord & bit)) {
+				*reservedWord |= bit;
+				map->numReservedPixels++;
+			}
+		}
+	}
+}
+
+RB_Size RB_getNumReservedPixels(RB_PixelMap* map) {
+	return map->numReservedPixels;
+}
+
+// Stops holding back the reserved pixels, and queues the ones next to a set pixel in a single pass over the map. The
+// rest are queued as usual once a neighbour is set. Returns false if that didn't queue anything, like when there were
+// none to release or nothing has been set yet.
+bool RB_releaseReservedPixels(RB_PixelMap* map, RB_AssignmentQueue* queue) {
+	if(map->numReservedPixels == 0) {
+		return false;
+	}
+
+	for(RB_Size i = 0; i < map->wordsPerRow * map->height; i++) {
+		map->reservedRows[i] = 0;
+	}
+	map->numReservedPixels = 0;
+
+	RB_Size queueSize = RB_getQueueSize(queue);
+	queueFrontierInBox(map, queue, 0, map->height - 1, 0, map->wordsPerRow - 1);
+
+	return RB_getQueueSize(queue) > queueSize;
+}
@@ -9,4 +9,12 @@ bool RB_colorsAreEqual(RB_Color color0, RB_Color color1) {
 // Returns true if the two coords are equal. Otherwise returns false.
 bool RB_coordsAreEqual(RB_Coord coord0, RB_Coord coord1) {
 	return coord0.x == coord1.x && coord0.y == coord1.y;
+}
+
+// Returns the square of the euclidean distance between the two colors.
+RB_ColorSquareDistance RB_getColorSquareDistance(RB_Color color0, RB_Color color1) {
+	RB_ColorChannelDifference dR = (RB_ColorChannelDifference) color0.r - color1.r;
+	RB_ColorChannelDifference dG = (RB_ColorChannelDifference) color0.g - color1.g;
+	RB_ColorChannelDifference dB = (RB_ColorChannelDifference) color0.b - color1.b;
+	return (RB_ColorSquareDistance) (dR * dR) + (dG * dG) + (dB * dB);
 }
\ No newline at end of file
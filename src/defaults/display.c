@@ -110,6 +110,11 @@ RB_Display* RB_createDisplay(
 }
 
 void RB_freeDisplay(RB_Display* ret) {
+	// Headless runs have no display.
+	if(ret == NULL) {
+		return;
+	}
+
 	printf("Freeing RB_Display!\n");
 	if(ret->texture != NULL) {
 		SDL_DestroyTexture(ret->texture);
@@ -133,6 +138,10 @@ void RB_freeDisplay(RB_Display* ret) {
 
 // Forces the display to update immediately.
 void RB_forceUpdateDisplay(RB_Display* display, bool interruptFramerate) {
+	if(display == NULL) {
+		return;
+	}
+
 	if(interruptFramerate) {
 		display->lastFrameProcTime = clock();
 	}
@@ -146,6 +155,10 @@ void RB_forceUpdateDisplay(RB_Display* display, bool interruptFramerate) {
 // If it has been a sufficiently long time since the last update, updates the display and returns 1.
 // Otherwise, does not update the display and returns 0.
 bool RB_updateDisplay(RB_Display* display) {
+	if(display == NULL) {
+		return false;
+	}
+
 	clock_t currentTime = clock();
 	double deltaT = ((double) (currentTime - display->lastFrameProcTime)) / CLOCKS_PER_SEC;
 	if(deltaT < 0 || deltaT >= display->secondsPerFrame) {
@@ -259,7 +272,11 @@ double calculateColorSimilarity(FloatColor realColor, FloatColor targetColor) {
 // Note: This function will convert the color to the displayed color format. You should NOT do that beforehand.
 void RB_setDisplayedPixelColor(RB_Display* disp, RB_Coord coord, RB_Color color) {
 	static double lowestVal = 0;
-	
+
+	if(disp == NULL) {
+		return;
+	}
+
 	FloatColor realColor = {
 		.r = ((double) color.r) / (disp->rRes - 1),
 		.g = ((double) color.g) / (disp->gRes - 1),
@@ -0,0 +1,248 @@
+#include "headers/RB_GrowthFronts.h"
+#include "headers/RB_AssignmentQueue.h"
+#include "headers/RB_PixelMap.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// The front of a coord that no front has queued or set.
+#define RB_NO_GROWTH_FRONT UINT8_MAX
+
+// Each front is padded out to whole cache lines, so fronts grown on different threads never write to the same one.
+#define RB_GROWTH_FRONT_ALIGNMENT 64
+
+typedef struct {
+	// NULL once the front has been merged into another.
+	_Alignas(RB_GROWTH_FRONT_ALIGNMENT) RB_AssignmentQueue* queue;
+
+	// The front this one was merged into, or itself.
+	int parent;
+
+	const char* name;
+
+	// Includes the weights of every front merged into this one.
+	uint32_t weight;
+
+	// How far the front is behind its share of the pixels, for weighted scheduling.
+	int64_t credit;
+} GrowthFront;
+
+struct RB_GrowthFronts_s {
+	GrowthFront* fronts;
+	int numFronts;
+
+	// The front that queued or set each coord, or RB_NO_GROWTH_FRONT, indexed by pixel index. Not updated by merges.
+	uint8_t* pixelFronts;
+
+	RB_FrontScheduling scheduling;
+	// The front chosen last, for round robin scheduling.
+	int lastChosen;
+
+	RB_Size width;
+	RB_Size height;
+};
+
+RB_GrowthFronts* RB_createGrowthFronts(
+	RB_Size width, RB_Size height,
+	const RB_GrowthFront* fronts, int numFronts,
+	RB_FrontScheduling scheduling, RB_QueueSampling sampling
+) {
+	if(numFronts < 1 || numFronts > RB_MAXIMUM_GROWTH_FRONTS) {
+		fprintf(stderr, "Error creating growth fronts: there must be between 1 and %d fronts!\n", RB_MAXIMUM_GROWTH_FRONTS);
+		return NULL;
+	}
+
+	RB_GrowthFronts* ret = (RB_GrowthFronts*) malloc(sizeof(RB_GrowthFronts));
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	ret->numFronts = numFronts;
+	ret->scheduling = scheduling;
+	ret->lastChosen = numFronts - 1;
+	ret->width = width;
+	ret->height = height;
+	ret->pixelFronts = (uint8_t*) malloc(sizeof(uint8_t) * width * height);
+	// GrowthFront's alignment makes its size a multiple of RB_GROWTH_FRONT_ALIGNMENT, like aligned_alloc needs.
+	ret->fronts = (GrowthFront*) aligned_alloc(RB_GROWTH_FRONT_ALIGNMENT, sizeof(GrowthFront) * numFronts);
+
+	if(ret->pixelFronts == NULL || ret->fronts == NULL) {
+		fprintf(stderr, "Error creating growth fronts: malloc failed!\n");
+		free(ret->pixelFronts);
+		free(ret->fronts);
+		free(ret);
+		return NULL;
+	}
+
+	for(RB_Size i = 0; i < width * height; i++) {
+		ret->pixelFronts[i] = RB_NO_GROWTH_FRONT;
+	}
+
+	// The pixel map never queues a coord twice, so every front can share the first front's tables.
+	RB_AssignmentQueue* firstQueue = RB_createAssignmentQueue(width * height, width, height);
+
+	for(int i = 0; i < numFronts; i++) {
+		RB_AssignmentQueue* queue = firstQueue;
+		if(i > 0 && firstQueue != NULL) {
+			queue = RB_createSharedAssignmentQueue(firstQueue, width * height);
+		}
+
+		ret->fronts[i] = (GrowthFront) {
+			.queue = queue,
+			.parent = i,
+			.name = fronts[i].name,
+			.weight = fronts[i].weight,
+			.credit = 0
+		};
+	}
+
+	for(int i = 0; i < numFronts; i++) {
+		if(ret->fronts[i].queue == NULL || !RB_setAssignmentQueueSampling(ret->fronts[i].queue, sampling)) {
+			fprintf(stderr, "Error creating growth fronts: could not create the queue for \"%s\"!\n", ret->fronts[i].name);
+			RB_freeGrowthFronts(ret);
+			return NULL;
+		}
+	}
+
+	return ret;
+}
+
+void RB_freeGrowthFronts(RB_GrowthFronts* fronts) {
+	if(fronts == NULL) {
+		return;
+	}
+
+	for(int i = 0; i < fronts->numFronts; i++) {
+		RB_freeAssignmentQueue(fronts->fronts[i].queue);
+	}
+
+	free(fronts->fronts);
+	free(fronts->pixelFronts);
+	free(fronts);
+}
+
+int RB_findGrowthFront(RB_GrowthFronts* fronts, int front) {
+	// Path halving: every front on the way is pointed at its grandparent, so the paths stay short.
+	while(fronts->fronts[front].parent != front) {
+		GrowthFront* current = fronts->fronts + front;
+		current->parent = fronts->fronts[current->parent].parent;
+		front = current->parent;
+	}
+
+	return front;
+}
+
+RB_AssignmentQueue* RB_getGrowthFrontQueue(RB_GrowthFronts* fronts, int front) {
+	return fronts->fronts[RB_findGrowthFront(fronts, front)].queue;
+}
+
+int RB_getCoordGrowthFront(RB_GrowthFronts* fronts, RB_Coord coord) {
+	uint8_t front = fronts->pixelFronts[RB_getPixelIndex(coord, fronts->width)];
+
+	if(front == RB_NO_GROWTH_FRONT) {
+		return -1;
+	}
+
+	return RB_findGrowthFront(fronts, front);
+}
+
+void RB_setCoordGrowthFront(RB_GrowthFronts* fronts, RB_Coord coord, int front) {
+	fronts->pixelFronts[RB_getPixelIndex(coord, fronts->width)] = (uint8_t) front;
+}
+
+int RB_mergeGrowthFronts(RB_GrowthFronts* fronts, RB_PixelMap* map, int a, int b) {
+	a = RB_findGrowthFront(fronts, a);
+	b = RB_findGrowthFront(fronts, b);
+
+	if(a == b) {
+		return a;
+	}
+
+	// Keep the bigger queue, so the fewest coords have to move.
+	if(RB_getQueueSize(fronts->fronts[b].queue) > RB_getQueueSize(fronts->fronts[a].queue)) {
+		int swap = a;
+		a = b;
+		b = swap;
+	}
+
+	GrowthFront* kept = fronts->fronts + a;
+	GrowthFront* absorbed = fronts->fronts + b;
+
+	RB_moveQueuedCoords(map, absorbed->queue, kept->queue);
+	RB_freeAssignmentQueue(absorbed->queue);
+
+	absorbed->queue = NULL;
+	absorbed->parent = a;
+	kept->weight += absorbed->weight;
+	kept->credit += absorbed->credit;
+
+	return a;
+}
+
+bool growthFrontHasQueuedCoords(RB_GrowthFronts* fronts, int front) {
+	return fronts->fronts[front].parent == front && !RB_isQueueEmpty(fronts->fronts[front].queue);
+}
+
+// The next front after the last one chosen that has queued coords.
+int chooseGrowthFrontInTurn(RB_GrowthFronts* fronts) {
+	for(int i = 1; i <= fronts->numFronts; i++) {
+		int front = (fronts->lastChosen + i) % fronts->numFronts;
+
+		if(growthFrontHasQueuedCoords(fronts, front)) {
+			fronts->lastChosen = front;
+			return front;
+		}
+	}
+
+	return -1;
+}
+
+/*
+Smooth weighted round robin. Every turn, each front with queued coords earns its weight in credit, and the front with
+the most credit is chosen and pays back the total weight. A front with weight w out of a total of W gets w of every W
+pixels, and its turns are spread out instead of coming in a run.
+*/
+int chooseGrowthFrontByWeight(RB_GrowthFronts* fronts) {
+	int best = -1;
+	int64_t totalWeight = 0;
+
+	for(int front = 0; front < fronts->numFronts; front++) {
+		if(!growthFrontHasQueuedCoords(fronts, front)) {
+			continue;
+		}
+
+		GrowthFront* current = fronts->fronts + front;
+		current->credit += current->weight;
+		totalWeight += current->weight;
+
+		if(best < 0 || current->credit > fronts->fronts[best].credit) {
+			best = front;
+		}
+	}
+
+	if(best >= 0) {
+		fronts->fronts[best].credit -= totalWeight;
+	}
+
+	return best;
+}
+
+int RB_chooseGrowthFront(RB_GrowthFronts* fronts) {
+	if(fronts->scheduling == RB_FRONT_SCHEDULING_WEIGHTED) {
+		return chooseGrowthFrontByWeight(fronts);
+	}
+
+	return chooseGrowthFrontInTurn(fronts);
+}
+
+bool RB_growthFrontsAreEmpty(RB_GrowthFronts* fronts) {
+	for(int front = 0; front < fronts->numFronts; front++) {
+		if(growthFrontHasQueuedCoords(fronts, front)) {
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,249 @@
+#include "headers/RB_MatchSchedule.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// The heap only compacts once it holds more than this many entries, so small schedules never bother.
+#define RB_MATCH_SCHEDULE_MINIMUM_COMPACT_SIZE 1024
+
+typedef struct {
+	uint32_t key;
+	RB_PixelIndex pixel;
+	// The entry is stale unless this equals the coord's version.
+	uint32_t version;
+	RB_Color color;
+	bool hasColor;
+} ScheduleEntry;
+
+struct RB_MatchSchedule_s {
+	ScheduleEntry* heap;
+	RB_Size heapSize;
+	RB_Size heapCapacity;
+
+	// Once the heap grows past this, the stale entries are thrown out.
+	RB_Size compactSize;
+
+	// The current version of every coord, indexed by pixel index. Bumped whenever the coord is rescheduled or
+	// unscheduled, which makes every entry it already has stale.
+	uint32_t* versions;
+
+	// The color every coord was last matched with, indexed like versions.
+	RB_Color* lastColors;
+	// One bit per coord, set once it has been matched.
+	uint64_t* lastColorsSet;
+
+	RB_Size width;
+	RB_Size height;
+};
+
+bool scheduleEntryIsStale(RB_MatchSchedule* schedule, ScheduleEntry* entry) {
+	return entry->version != schedule->versions[entry->pixel];
+}
+
+void siftScheduleEntryUp(RB_MatchSchedule* schedule, RB_Size index) {
+	ScheduleEntry entry = schedule->heap[index];
+
+	while(index > 0) {
+		RB_Size parent = (index - 1) / 2;
+
+		if(schedule->heap[parent].key <= entry.key) {
+			break;
+		}
+
+		schedule->heap[index] = schedule->heap[parent];
+		index = parent;
+	}
+
+	schedule->heap[index] = entry;
+}
+
+void siftScheduleEntryDown(RB_MatchSchedule* schedule, RB_Size index) {
+	ScheduleEntry entry = schedule->heap[index];
+
+	while(true) {
+		RB_Size child = (index * 2) + 1;
+
+		if(child >= schedule->heapSize) {
+			break;
+		}
+
+		if(child + 1 < schedule->heapSize && schedule->heap[child + 1].key < schedule->heap[child].key) {
+			child++;
+		}
+
+		if(schedule->heap[child].key >= entry.key) {
+			break;
+		}
+
+		schedule->heap[index] = schedule->heap[child];
+		index = child;
+	}
+
+	schedule->heap[index] = entry;
+}
+
+void removeTopScheduleEntry(RB_MatchSchedule* schedule) {
+	schedule->heapSize--;
+
+	if(schedule->heapSize > 0) {
+		schedule->heap[0] = schedule->heap[schedule->heapSize];
+		siftScheduleEntryDown(schedule, 0);
+	}
+}
+
+// Throws out every stale entry and rebuilds the heap from what's left.
+void compactSchedule(RB_MatchSchedule* schedule) {
+	RB_Size numLive = 0;
+
+	for(RB_Size i = 0; i < schedule->heapSize; i++) {
+		if(!scheduleEntryIsStale(schedule, schedule->heap + i)) {
+			schedule->heap[numLive] = schedule->heap[i];
+			numLive++;
+		}
+	}
+
+	schedule->heapSize = numLive;
+
+	for(RB_Size i = numLive / 2; i > 0; i--) {
+		siftScheduleEntryDown(schedule, i - 1);
+	}
+
+	// Wait until there have been at least as many pushes as there are live entries, so compacting stays O(1) per push.
+	schedule->compactSize = (numLive * 2) + RB_MATCH_SCHEDULE_MINIMUM_COMPACT_SIZE;
+}
+
+void pushScheduleEntry(RB_MatchSchedule* schedule, RB_Coord coord, RB_Color color, uint32_t key, bool hasColor) {
+	if(schedule->heapSize >= schedule->compactSize) {
+		compactSchedule(schedule);
+	}
+
+	if(schedule->heapSize == schedule->heapCapacity) {
+		RB_Size newCapacity = schedule->heapCapacity * 2;
+		ScheduleEntry* newHeap = (ScheduleEntry*) realloc(schedule->heap, sizeof(ScheduleEntry) * newCapacity);
+
+		if(newHeap == NULL) {
+			fprintf(stderr, "Error scheduling coord: could not grow the heap!\n");
+			return;
+		}
+
+		schedule->heap = newHeap;
+		schedule->heapCapacity = newCapacity;
+	}
+
+	RB_PixelIndex pixel = RB_getPixelIndex(coord, schedule->width);
+	schedule->versions[pixel]++;
+
+	schedule->heap[schedule->heapSize] = (ScheduleEntry) {
+		.key = key,
+		.pixel = pixel,
+		.version = schedule->versions[pixel],
+		.color = color,
+		.hasColor = hasColor
+	};
+	schedule->heapSize++;
+
+	siftScheduleEntryUp(schedule, schedule->heapSize - 1);
+}
+
+// Pops stale entries until a live one is on top, or the heap is empty.
+void discardStaleScheduleEntries(RB_MatchSchedule* schedule) {
+	while(schedule->heapSize > 0 && scheduleEntryIsStale(schedule, schedule->heap)) {
+		removeTopScheduleEntry(schedule);
+	}
+}
+
+RB_MatchSchedule* RB_createMatchSchedule(RB_Size width, RB_Size height) {
+	RB_MatchSchedule* ret = (RB_MatchSchedule*) malloc(sizeof(RB_MatchSchedule));
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	ret->width = width;
+	ret->height = height;
+	ret->heapSize = 0;
+	ret->heapCapacity = RB_MATCH_SCHEDULE_MINIMUM_COMPACT_SIZE;
+	ret->compactSize = RB_MATCH_SCHEDULE_MINIMUM_COMPACT_SIZE;
+	ret->heap = (ScheduleEntry*) malloc(sizeof(ScheduleEntry) * ret->heapCapacity);
+	ret->versions = (uint32_t*) calloc(width * height, sizeof(uint32_t));
+	ret->lastColors = (RB_Color*) malloc(sizeof(RB_Color) * width * height);
+	ret->lastColorsSet = (uint64_t*) calloc(((width * height) + 63) / 64, sizeof(uint64_t));
+
+	if(ret->heap == NULL || ret->versions == NULL || ret->lastColors == NULL || ret->lastColorsSet == NULL) {
+		fprintf(stderr, "Error creating match schedule: malloc failed!\n");
+		RB_freeMatchSchedule(ret);
+		return NULL;
+	}
+
+	return ret;
+}
+
+void RB_freeMatchSchedule(RB_MatchSchedule* schedule) {
+	if(schedule == NULL) {
+		return;
+	}
+
+	free(schedule->heap);
+	free(schedule->versions);
+	free(schedule->lastColors);
+	free(schedule->lastColorsSet);
+	free(schedule);
+}
+
+void RB_scheduleMatch(RB_MatchSchedule* schedule, RB_Coord coord, RB_Color color, uint32_t key) {
+	RB_PixelIndex pixel = RB_getPixelIndex(coord, schedule->width);
+	schedule->lastColors[pixel] = color;
+	schedule->lastColorsSet[pixel / 64] |= ((uint64_t) 1) << (pixel % 64);
+
+	pushScheduleEntry(schedule, coord, color, key, true);
+}
+
+void RB_scheduleUnmatchedCoord(RB_MatchSchedule* schedule, RB_Coord coord, uint32_t estimate) {
+	pushScheduleEntry(schedule, coord, (RB_Color) {0, 0, 0}, estimate, false);
+}
+
+void RB_unscheduleCoord(RB_MatchSchedule* schedule, RB_Coord coord) {
+	schedule->versions[RB_getPixelIndex(coord, schedule->width)]++;
+}
+
+bool RB_getLastScheduledColor(RB_MatchSchedule* schedule, RB_Coord coord, RB_Color* out) {
+	RB_PixelIndex pixel = RB_getPixelIndex(coord, schedule->width);
+
+	if(!(schedule->lastColorsSet[pixel / 64] & (((uint64_t) 1) << (pixel % 64)))) {
+		return false;
+	}
+
+	*out = schedule->lastColors[pixel];
+	return true;
+}
+
+bool RB_popScheduledMatch(RB_MatchSchedule* schedule, RB_ScheduledMatch* out) {
+	discardStaleScheduleEntries(schedule);
+
+	if(schedule->heapSize == 0) {
+		return false;
+	}
+
+	ScheduleEntry top = schedule->heap[0];
+	removeTopScheduleEntry(schedule);
+
+	*out = (RB_ScheduledMatch) {
+		.coord = RB_getPixelIndexCoord(top.pixel, schedule->width),
+		.color = top.color,
+		.key = top.key,
+		.hasColor = top.hasColor
+	};
+
+	return true;
+}
+
+uint32_t RB_peekScheduledKey(RB_MatchSchedule* schedule) {
+	discardStaleScheduleEntries(schedule);
+
+	if(schedule->heapSize == 0) {
+		return UINT32_MAX;
+	}
+
+	return schedule->heap[0].key;
+}
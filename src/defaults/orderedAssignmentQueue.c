@@ -0,0 +1,397 @@
+#include "headers/RB_AssignmentQueue.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+/*
+An assignmentQueue that never uses rand(), so the order pixels are set in only depends on the seeds.
+Within each priority level, coords are chosen oldest first (breadth first), or newest first (depth first) when built
+with RB_ORDERED_QUEUE_NEWEST_FIRST defined.
+
+Every priority level is a ring buffer of coords, stored as RB_PixelIndexes, in the order they were added. Removing a coord from the middle of a
+ring leaves a tombstone behind instead of shifting everything after it, and tombstones at either end of a ring are
+trimmed as soon as they appear, so both ends always hold live coords. When a ring fills up, its live coords are copied
+into a new ring twice as large as they need, which drops every tombstone. Every operation is O(1) amortized.
+
+There's no randomness to weigh or bias, so only RB_QUEUE_SAMPLING_UNIFORM is supported and coord weights are ignored.
+*/
+
+#define RB_QUEUE_INDEX_UNQUEUED -1
+// The smallest ring a priority level uses. Always a power of two.
+#define RB_QUEUE_INITIAL_LEVEL_CAPACITY 64
+
+// The value a ring slot holds once its coord has been removed. No map is big enough to have a pixel with this index.
+static const RB_PixelIndex tombstone = UINT32_MAX;
+
+// The tables indexed by pixel index, which RB_createSharedAssignmentQueue shares between queues.
+typedef struct {
+	int numQueues;
+
+	int32_t* coordIndexes;
+	uint8_t* coordLevels;
+} PixelTables;
+
+struct RB_AssignmentQueue_s {
+	// Each level's ring. levelCapacities are powers of two, so slot indexes wrap with a mask.
+	RB_PixelIndex* levelPixels[RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES];
+	RB_Size levelCapacities[RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES];
+	RB_Size levelHeads[RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES];
+	// The number of slots from the head to the tail, tombstones included.
+	RB_Size levelUsed[RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES];
+	// The number of slots that hold live coords.
+	RB_Size levelLens[RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES];
+	uint64_t nonEmptyLevels;
+
+	RB_Size coordLen;
+	RB_Size maxCoordLen;
+
+	// The slot of each queued coord within its level's ring, or RB_QUEUE_INDEX_UNQUEUED, indexed by pixel index.
+	int32_t* coordIndexes;
+	// The level of each queued coord, indexed by pixel index. Only meaningful for queued coords.
+	uint8_t* coordLevels;
+	PixelTables* pixelTables;
+	RB_Size xRange;
+	RB_Size yRange;
+};
+
+PixelTables* createPixelTables(RB_Size xRange, RB_Size yRange) {
+	PixelTables* ret = malloc(
+		sizeof(PixelTables)
+		+ (sizeof(int32_t) * xRange * yRange)
+		+ (sizeof(uint8_t) * xRange * yRange)
+	);
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	ret->numQueues = 0;
+	ret->coordIndexes = (int32_t*) (ret + 1);
+	ret->coordLevels = (uint8_t*) (ret->coordIndexes + (xRange * yRange));
+
+	for(RB_Size i = 0; i < xRange * yRange; i++) {
+		ret->coordIndexes[i] = RB_QUEUE_INDEX_UNQUEUED;
+	}
+
+	return ret;
+}
+
+RB_AssignmentQueue* createQueueWithPixelTables(RB_Size size, RB_Size xRange, RB_Size yRange, PixelTables* tables) {
+	RB_AssignmentQueue* ret = malloc(sizeof(RB_AssignmentQueue));
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	// The levels' rings are allocated the first time each level is used.
+	for(int level = 0; level < RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES; level++) {
+		ret->levelPixels[level] = NULL;
+		ret->levelCapacities[level] = 0;
+		ret->levelHeads[level] = 0;
+		ret->levelUsed[level] = 0;
+		ret->levelLens[level] = 0;
+	}
+	ret->nonEmptyLevels = 0;
+
+	ret->maxCoordLen = size;
+	ret->coordLen = 0;
+
+	ret->coordIndexes = tables->coordIndexes;
+	ret->coordLevels = tables->coordLevels;
+	ret->pixelTables = tables;
+	ret->xRange = xRange;
+	ret->yRange = yRange;
+
+	tables->numQueues++;
+
+	return ret;
+}
+
+// Allocates an assignmentQueue capable of storing the specified number of pixels.
+RB_AssignmentQueue* RB_createAssignmentQueue(RB_Size size, RB_Size xRange, RB_Size yRange) {
+	PixelTables* tables = createPixelTables(xRange, yRange);
+
+	if(tables == NULL) {
+		return NULL;
+	}
+
+	RB_AssignmentQueue* ret = createQueueWithPixelTables(size, xRange, yRange, tables);
+
+	if(ret == NULL) {
+		free(tables);
+	}
+
+	return ret;
+}
+
+RB_AssignmentQueue* RB_createSharedAssignmentQueue(RB_AssignmentQueue* shared, RB_Size size) {
+	return createQueueWithPixelTables(size, shared->xRange, shared->yRange, shared->pixelTables);
+}
+
+// Frees a previously allocated assignmentQueue
+void RB_freeAssignmentQueue(RB_AssignmentQueue* queue) {
+	if(queue == NULL) {
+		return;
+	}
+
+	printf("Freeing RB_AssignmentQueue!\n");
+
+	for(int level = 0; level < RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES; level++) {
+		free(queue->levelPixels[level]);
+	}
+
+	queue->pixelTables->numQueues--;
+	if(queue->pixelTables->numQueues == 0) {
+		free(queue->pixelTables);
+	}
+
+	free(queue);
+}
+
+// Returns true if the queue is empty. Otherwise, returns false.
+bool RB_isQueueEmpty(RB_AssignmentQueue* queue) {
+	return queue->coordLen == 0;
+}
+
+bool RB_isQueueFull(RB_AssignmentQueue* queue) {
+	return queue->coordLen == queue->maxCoordLen;
+}
+
+RB_Size RB_getQueueSize(RB_AssignmentQueue* queue) {
+	return queue->coordLen;
+}
+
+RB_Size RB_getQueueCapacity(RB_AssignmentQueue* queue) {
+	return queue->maxCoordLen;
+}
+
+bool isTombstone(RB_PixelIndex pixel) {
+	return pixel == tombstone;
+}
+
+// The ring slot i places after the level's head.
+RB_Size getLevelSlot(RB_AssignmentQueue* queue, int level, RB_Size i) {
+	return (queue->levelHeads[level] + i) & (queue->levelCapacities[level] - 1);
+}
+
+// Chooses the oldest (or newest) coord from the best non-empty priority level and returns it.
+RB_Coord RB_chooseCoordFromAssignmentQueue(RB_AssignmentQueue* queue) {
+	if(RB_isQueueEmpty(queue)) {
+		fprintf(stderr, "AssignmentQueue is empty!!\n");
+		return (RB_Coord) { .x = -1, .y = -1 };
+	}
+
+	int level = __builtin_ctzll(queue->nonEmptyLevels);
+
+#ifdef RB_ORDERED_QUEUE_NEWEST_FIRST
+	RB_PixelIndex pixel = queue->levelPixels[level][getLevelSlot(queue, level, queue->levelUsed[level] - 1)];
+#else
+	RB_PixelIndex pixel = queue->levelPixels[level][queue->levelHeads[level]];
+#endif
+
+	return RB_getPixelIndexCoord(pixel, queue->xRange);
+}
+
+bool RB_coordIsWithinQueueBounds(RB_AssignmentQueue* queue, RB_Coord coord) {
+	return (
+		coord.x >= 0
+		&& coord.x < queue->xRange
+		&& coord.y >= 0
+		&& coord.y < queue->yRange
+	);
+}
+
+// Returns true if the pixel's slot is one of this queue's. Only the slots from the level's head to its tail count,
+// since the rest of a ring can hold anything.
+bool pixelIsInQueue(RB_AssignmentQueue* queue, RB_PixelIndex pixel) {
+	int32_t slot = queue->coordIndexes[pixel];
+
+	if(slot == RB_QUEUE_INDEX_UNQUEUED) {
+		return false;
+	}
+
+	int level = queue->coordLevels[pixel];
+	RB_Size capacity = queue->levelCapacities[level];
+	return (
+		slot < capacity
+		&& ((slot - queue->levelHeads[level]) & (capacity - 1)) < queue->levelUsed[level]
+		&& queue->levelPixels[level][slot] == pixel
+	);
+}
+
+bool RB_coordIsInQueue(RB_AssignmentQueue* queue, RB_Coord coord) {
+	return (
+		RB_coordIsWithinQueueBounds(queue, coord)
+		&& pixelIsInQueue(queue, RB_getPixelIndex(coord, queue->xRange))
+	);
+}
+
+// Takes the pixel out of its level, leaving a tombstone if it was in the middle of the ring. The pixel must be queued.
+void removePixelFromLevel(RB_AssignmentQueue* queue, RB_PixelIndex pixel) {
+	int level = queue->coordLevels[pixel];
+	RB_PixelIndex* ring = queue->levelPixels[level];
+
+	ring[queue->coordIndexes[pixel]] = tombstone;
+	queue->coordIndexes[pixel] = RB_QUEUE_INDEX_UNQUEUED;
+	queue->levelLens[level]--;
+
+	if(queue->levelLens[level] == 0) {
+		queue->levelHeads[level] = 0;
+		queue->levelUsed[level] = 0;
+		queue->nonEmptyLevels &= ~(((uint64_t) 1) << level);
+		return;
+	}
+
+	// Each slot is only trimmed once, so this is O(1) amortized.
+	while(isTombstone(ring[queue->levelHeads[level]])) {
+		queue->levelHeads[level] = getLevelSlot(queue, level, 1);
+		queue->levelUsed[level]--;
+	}
+	while(isTombstone(ring[getLevelSlot(queue, level, queue->levelUsed[level] - 1)])) {
+		queue->levelUsed[level]--;
+	}
+}
+
+// Copies the level's live coords, in order, into a new ring with room for at least twice as many. Returns false if
+// the new ring couldn't be allocated, in which case the level is unchanged.
+bool compactLevel(RB_AssignmentQueue* queue, int level) {
+	RB_Size newCapacity = RB_QUEUE_INITIAL_LEVEL_CAPACITY;
+	while(newCapacity < (queue->levelLens[level] + 1) * 2) {
+		newCapacity *= 2;
+	}
+
+	RB_PixelIndex* newPixels = (RB_PixelIndex*) malloc(sizeof(RB_PixelIndex) * newCapacity);
+
+	if(newPixels == NULL) {
+		return false;
+	}
+
+	RB_Size newUsed = 0;
+	for(RB_Size i = 0; i < queue->levelUsed[level]; i++) {
+		RB_PixelIndex pixel = queue->levelPixels[level][getLevelSlot(queue, level, i)];
+		if(isTombstone(pixel)) {
+			continue;
+		}
+
+		newPixels[newUsed] = pixel;
+		queue->coordIndexes[pixel] = newUsed;
+		newUsed++;
+	}
+
+	free(queue->levelPixels[level]);
+	queue->levelPixels[level] = newPixels;
+	queue->levelCapacities[level] = newCapacity;
+	queue->levelHeads[level] = 0;
+	queue->levelUsed[level] = newUsed;
+
+	return true;
+}
+
+// Puts the pixel at the tail of the level's ring, compacting the ring if it's full. Returns false if it couldn't.
+bool addPixelToLevel(RB_AssignmentQueue* queue, RB_PixelIndex pixel, int level) {
+	if(queue->levelUsed[level] == queue->levelCapacities[level] && !compactLevel(queue, level)) {
+		return false;
+	}
+
+	RB_Size slot = getLevelSlot(queue, level, queue->levelUsed[level]);
+	queue->levelPixels[level][slot] = pixel;
+	queue->coordIndexes[pixel] = slot;
+	queue->coordLevels[pixel] = level;
+	queue->levelUsed[level]++;
+	queue->levelLens[level]++;
+	queue->nonEmptyLevels |= ((uint64_t) 1) << level;
+
+	return true;
+}
+
+// The level that coords with the specified priorityIndex are stored in.
+int getPriorityLevel(RB_Size priorityIndex) {
+	if(priorityIndex < 0 || priorityIndex >= RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES) {
+		return RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES - 1;
+	}
+
+	return priorityIndex;
+}
+
+// If the coord is in the Queue, removes it.
+void RB_removeCoordFromAssignmentQueue(RB_AssignmentQueue* queue, RB_Coord coord) {
+	if(RB_coordIsInQueue(queue, coord)) {
+		removePixelFromLevel(queue, RB_getPixelIndex(coord, queue->xRange));
+		queue->coordLen--;
+	} else {
+		fprintf(stderr, "Error removing coord from queue: Coord(%ld, %ld) is not in queue.\n", (long) coord.x, (long) coord.y);
+	}
+}
+
+/*
+- If the pixel is not already queued or assigned, adds the pixel to the back of the specified priority level.
+- If the pixel is already queued at another priority, moves it to the back of the specified priority level.
+*/
+void RB_addCoordToAssignmentQueue(RB_AssignmentQueue* queue, RB_Coord toAdd, RB_Size priorityIndex) {
+	if(!RB_coordIsWithinQueueBounds(queue, toAdd)) {
+		fprintf(stderr, "Error adding coord to queue: Coord(%ld, %ld) is out of Bounds(%ld, %ld)!\n",
+			(long) toAdd.x, (long) toAdd.y, (long) queue->xRange, (long) queue->yRange
+		);
+		return;
+	}
+
+	int level = getPriorityLevel(priorityIndex);
+	RB_PixelIndex pixel = RB_getPixelIndex(toAdd, queue->xRange);
+
+	if(pixelIsInQueue(queue, pixel)) {
+		if(queue->coordLevels[pixel] != level) {
+			int oldLevel = queue->coordLevels[pixel];
+			removePixelFromLevel(queue, pixel);
+			if(!addPixelToLevel(queue, pixel, level)) {
+				// Compacting the old level can fail too, but then the coord is lost either way.
+				fprintf(stderr, "Error changing coord's priority: could not grow priority level %d!\n", level);
+				if(!addPixelToLevel(queue, pixel, oldLevel)) {
+					queue->coordLen--;
+				}
+			}
+		}
+		return;
+	}
+
+	if(RB_isQueueFull(queue)) {
+		fprintf(stderr, "Error adding coord to queue: Queue is full!\n");
+		return;
+	}
+
+	if(!addPixelToLevel(queue, pixel, level)) {
+		fprintf(stderr, "Error adding coord to queue: could not grow priority level %d!\n", level);
+		return;
+	}
+
+	queue->coordLen++;
+}
+
+bool RB_setAssignmentQueueSampling(RB_AssignmentQueue* queue, RB_QueueSampling sampling) {
+	(void) queue;
+
+	if(sampling != RB_QUEUE_SAMPLING_UNIFORM) {
+		fprintf(stderr, "Error setting queue sampling: this queue chooses coords in order, so it only supports uniform sampling!\n");
+		return false;
+	}
+
+	return true;
+}
+
+RB_QueueSampling RB_getAssignmentQueueSampling(RB_AssignmentQueue* queue) {
+	(void) queue;
+	return RB_QUEUE_SAMPLING_UNIFORM;
+}
+
+// Weights only matter to weighted sampling, so they're ignored.
+void RB_setCoordWeightInAssignmentQueue(RB_AssignmentQueue* queue, RB_Coord coord, uint32_t weight) {
+	(void) weight;
+
+	if(!RB_coordIsInQueue(queue, coord)) {
+		fprintf(stderr, "Error setting coord weight: Coord(%ld, %ld) is not in queue.\n", (long) coord.x, (long) coord.y);
+	}
+}
+
+// The order doesn't depend on where the seeds are.
+void RB_markSeedInAssignmentQueue(RB_AssignmentQueue* queue, RB_Coord coord) {
+	(void) queue;
+	(void) coord;
+}
@@ -0,0 +1,434 @@
+#include "headers/RB_PartitionedColorPool.h"
+#include "headers/RB_ColorPool.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+// Partitions aren't rebalanced once their fair share of the colors is smaller than this. Rebuilding a partition costs
+// about the same no matter how few colors it holds, and queries that spill into neighbouring partitions are cheap
+// by then anyway.
+#define RB_MINIMUM_PARTITION_SHARE_TO_REBALANCE 4096
+
+typedef struct {
+	pthread_mutex_t lock;
+
+	// NULL when the partition has no colors.
+	RB_ColorPool* pool;
+	RB_Size numAvailable;
+
+	// The partition owns every color with rBegin <= r < rEnd. The range always holds at least one red value.
+	RB_ColorChannelSize rBegin;
+	RB_ColorChannelSize rEnd;
+
+	// When numAvailable drops below this, the partitions are rebalanced. 0 to never rebalance.
+	RB_Size rebalanceThreshold;
+} ColorPartition;
+
+struct RB_PartitionedColorPool_s {
+	ColorPartition* partitions;
+	int numPartitions;
+
+	// Queries hold this for reading, so the slabs can't move under them. Rebalancing holds it for writing.
+	pthread_rwlock_t layoutLock;
+	// Incremented by every rebalance, so that threads that asked for the same rebalance only do it once.
+	uint_fast32_t layoutGeneration;
+
+	// The remaining uses of every color, indexed by ((r * gSize) + g) * bSize + b. This is the source of truth that
+	// partitions are rebuilt from. A color's count is only written while its partition is locked.
+	RB_ColorCount* remaining;
+
+	RB_ColorChannelSize rSize;
+	RB_ColorChannelSize gSize;
+	RB_ColorChannelSize bSize;
+};
+
+RB_Size getColorRemainingIndex(RB_PartitionedColorPool* pool, RB_Color color) {
+	return (((RB_Size) color.r * pool->gSize) + color.g) * pool->bSize + color.b;
+}
+
+// The square distance from the color to the closest color the partition could own.
+RB_ColorSquareDistance getPartitionSquareDistance(ColorPartition* partition, RB_Color color) {
+	RB_ColorChannelDifference dR = 0;
+
+	if(color.r < partition->rBegin) {
+		dR = (RB_ColorChannelDifference) partition->rBegin - color.r;
+	} else if(color.r >= partition->rEnd) {
+		dR = (RB_ColorChannelDifference) color.r - (partition->rEnd - 1);
+	}
+
+	return (RB_ColorSquareDistance) (dR * dR);
+}
+
+// Must be called with the layout lock held.
+int getPartitionIndex(RB_PartitionedColorPool* pool, RB_ColorChannel r) {
+	for(int i = 0; i < pool->numPartitions - 1; i++) {
+		if(r < pool->partitions[i].rEnd) {
+			return i;
+		}
+	}
+
+	return pool->numPartitions - 1;
+}
+
+/*
+Moves the slabs so every partition holds about the same share of the remaining counts. Must be called with the layout
+lock held for writing.
+1) Count the remaining uses in every red slice of the cube.
+2) Cut the slices into numPartitions runs that each hold as close to an equal share of the uses as possible.
+3) Rebuild the pools of the partitions whose runs changed, straight from the remaining counts. A partition that kept
+its run already holds exactly those colors, so its pool is kept as it is.
+*/
+bool buildPartitions(RB_PartitionedColorPool* pool) {
+	RB_Size* sliceAvailable = (RB_Size*) calloc(pool->rSize, sizeof(RB_Size));
+
+	if(sliceAvailable == NULL) {
+		return false;
+	}
+
+	RB_Size sliceSize = (RB_Size) pool->gSize * (RB_Size) pool->bSize;
+	RB_Size totalAvailable = 0;
+	RB_Size colorIndex = 0;
+	for(RB_ColorChannelSize r = 0; r < pool->rSize; r++) {
+		for(RB_Size i = 0; i < sliceSize; i++) {
+			sliceAvailable[r] += pool->remaining[colorIndex];
+			colorIndex++;
+		}
+		totalAvailable += sliceAvailable[r];
+	}
+
+	RB_Size share = totalAvailable / pool->numPartitions;
+
+	RB_ColorChannelSize r = 0;
+	RB_Size assigned = 0;
+
+	for(int p = 0; p < pool->numPartitions; p++) {
+		ColorPartition* partition = pool->partitions + p;
+		bool isLast = (p == pool->numPartitions - 1);
+
+		// Take slices until this partition's running total reaches its share, leaving at least one slice for each
+		// of the partitions after it.
+		RB_Size target = (totalAvailable * (p + 1)) / pool->numPartitions;
+		RB_ColorChannelSize slicesToLeave = pool->numPartitions - 1 - p;
+		RB_ColorChannelSize rBegin = r;
+
+		while(r < pool->rSize - slicesToLeave && (isLast || assigned < target || r == rBegin)) {
+			assigned += sliceAvailable[r];
+			r++;
+		}
+
+		bool runChanged = (rBegin != partition->rBegin || r != partition->rEnd);
+		partition->rBegin = rBegin;
+		partition->rEnd = r;
+		partition->numAvailable = 0;
+
+		for(RB_ColorChannelSize sliceR = partition->rBegin; sliceR < partition->rEnd; sliceR++) {
+			partition->numAvailable += sliceAvailable[sliceR];
+		}
+
+		// Slices can't be split, so a partition can end up with much less than its share. Measuring from what it
+		// actually got keeps it from asking for another rebalance straight away.
+		RB_Size thresholdBase = (partition->numAvailable < share)? partition->numAvailable : share;
+		partition->rebalanceThreshold = (thresholdBase >= RB_MINIMUM_PARTITION_SHARE_TO_REBALANCE)? thresholdBase / 8 : 0;
+
+		// A partition whose build failed last time has no pool, even though it has colors.
+		if(!runChanged && (partition->pool != NULL || partition->numAvailable == 0)) {
+			continue;
+		}
+
+		RB_freeColorPool(partition->pool);
+		partition->pool = NULL;
+
+		if(partition->numAvailable == 0) {
+			continue;
+		}
+
+		partition->pool = RB_createColorPoolFromCounts(
+			pool->remaining, partition->rBegin, partition->rEnd, pool->gSize, pool->bSize
+		);
+
+		if(partition->pool == NULL) {
+			// Searches treat it as empty until a rebalance manages to build it.
+			partition->numAvailable = 0;
+			free(sliceAvailable);
+			return false;
+		}
+	}
+
+	free(sliceAvailable);
+	pool->layoutGeneration++;
+
+	return true;
+}
+
+void rebalancePartitions(RB_PartitionedColorPool* pool, uint_fast32_t generationSeen) {
+	pthread_rwlock_wrlock(&(pool->layoutLock));
+
+	// Another thread may have rebalanced since this one decided to.
+	if(pool->layoutGeneration == generationSeen) {
+		if(!buildPartitions(pool)) {
+			fprintf(stderr, "Error rebalancing color pool partitions: out of memory! Partitions may be missing colors.\n");
+		}
+	}
+
+	pthread_rwlock_unlock(&(pool->layoutLock));
+}
+
+RB_PartitionedColorPool* RB_createPartitionedColorPool(
+	RB_ColorChannelSize rSize,
+	RB_ColorChannelSize gSize,
+	RB_ColorChannelSize bSize,
+	RB_ColorCount multiplicity,
+	int numPartitions
+) {
+	if(numPartitions < 1 || (RB_ColorChannelSize) numPartitions > rSize) {
+		fprintf(stderr, "Error creating partitioned color pool: there must be between 1 and rSize partitions!\n");
+		return NULL;
+	}
+
+	if(multiplicity < 1) {
+		fprintf(stderr, "Error creating partitioned color pool: multiplicity must be at least 1!\n");
+		return NULL;
+	}
+
+	RB_PartitionedColorPool* ret = (RB_PartitionedColorPool*) malloc(sizeof(RB_PartitionedColorPool));
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	RB_Size numColors = (RB_Size) rSize * gSize * bSize;
+
+	ret->rSize = rSize;
+	ret->gSize = gSize;
+	ret->bSize = bSize;
+	ret->numPartitions = numPartitions;
+	ret->layoutGeneration = 0;
+	ret->remaining = (RB_ColorCount*) malloc(sizeof(RB_ColorCount) * numColors);
+	ret->partitions = (ColorPartition*) malloc(sizeof(ColorPartition) * numPartitions);
+
+	if(ret->remaining == NULL || ret->partitions == NULL) {
+		free(ret->remaining);
+		free(ret->partitions);
+		free(ret);
+		return NULL;
+	}
+
+	for(RB_Size i = 0; i < numColors; i++) {
+		ret->remaining[i] = multiplicity;
+	}
+
+	pthread_rwlock_init(&(ret->layoutLock), NULL);
+	for(int i = 0; i < numPartitions; i++) {
+		pthread_mutex_init(&(ret->partitions[i].lock), NULL);
+		ret->partitions[i].pool = NULL;
+		// No run is empty, so the first build sees every partition's run as changed.
+		ret->partitions[i].rBegin = 0;
+		ret->partitions[i].rEnd = 0;
+	}
+
+	if(!buildPartitions(ret)) {
+		fprintf(stderr, "Error creating partitioned color pool: could not build the partitions!\n");
+		RB_freePartitionedColorPool(ret);
+		return NULL;
+	}
+
+	return ret;
+}
+
+void RB_freePartitionedColorPool(RB_PartitionedColorPool* pool) {
+	if(pool == NULL) {
+		return;
+	}
+
+	for(int i = 0; i < pool->numPartitions; i++) {
+		RB_freeColorPool(pool->partitions[i].pool);
+		pthread_mutex_destroy(&(pool->partitions[i].lock));
+	}
+
+	pthread_rwlock_destroy(&(pool->layoutLock));
+	free(pool->partitions);
+	free(pool->remaining);
+	free(pool);
+}
+
+int RB_getNumColorPoolPartitions(RB_PartitionedColorPool* pool) {
+	return pool->numPartitions;
+}
+
+int RB_getColorPoolPartition(RB_PartitionedColorPool* pool, RB_Color color) {
+	pthread_rwlock_rdlock(&(pool->layoutLock));
+	int ret = getPartitionIndex(pool, color.r);
+	pthread_rwlock_unlock(&(pool->layoutLock));
+	return ret;
+}
+
+// Removes one use of the color from the partition. The partition must be locked, and must own the color. Returns
+// false if the color couldn't be removed, in which case the counts are left alone.
+bool removeColorFromPartition(RB_PartitionedColorPool* pool, ColorPartition* partition, RB_Color color) {
+	if(color.r < partition->rBegin || color.r >= partition->rEnd) {
+		fprintf(stderr, "Error: partition [%d, %d) does not own the color being removed from it!\n", (int) partition->rBegin, (int) partition->rEnd);
+		return false;
+	}
+
+	if(!RB_removeColorFromPool(partition->pool, color)) {
+		fprintf(stderr, "Error: partition [%d, %d) could not remove a color it owns!\n", (int) partition->rBegin, (int) partition->rEnd);
+		return false;
+	}
+
+	partition->numAvailable--;
+	pool->remaining[getColorRemainingIndex(pool, color)]--;
+	return true;
+}
+
+// Finds the closest color in the partition. The partition must be locked. Returns false if it has no colors.
+bool findIdealColorInPartition(ColorPartition* partition, RB_Color desired, RB_Color* out, RB_ColorSquareDistance* outDistance) {
+	if(partition->numAvailable == 0) {
+		return false;
+	}
+
+	*out = RB_findIdealAvailableColor(partition->pool, desired);
+	*outDistance = RB_getColorSquareDistance(*out, desired);
+	return true;
+}
+
+/*
+1) Search the partition that owns the desired color. If no other partition is as close to the desired color as the
+color that was found, that color is ideal, and only one lock was ever taken. This is the common case.
+2) Otherwise, lock every partition that could hold something closer (in order, so threads can't deadlock), search all
+of them, and take the closest color. The home partition was unlocked in between, so its best color may have been taken
+by another thread, in which case the partitions that were left out may now be close enough to matter. If so, repeat
+with every partition.
+*/
+bool RB_takeIdealAvailableColor(RB_PartitionedColorPool* pool, RB_Color desired, RB_Color* out) {
+	pthread_rwlock_rdlock(&(pool->layoutLock));
+
+	uint_fast32_t generation = pool->layoutGeneration;
+	int home = getPartitionIndex(pool, desired.r);
+	ColorPartition* homePartition = pool->partitions + home;
+
+	RB_Color best;
+	RB_ColorSquareDistance bestDistance = UINT_FAST32_MAX;
+	int bestPartition = -1;
+
+	pthread_mutex_lock(&(homePartition->lock));
+
+	if(findIdealColorInPartition(homePartition, desired, &best, &bestDistance)) {
+		bestPartition = home;
+	}
+
+	bool othersCouldBeCloser = false;
+	for(int i = 0; i < pool->numPartitions; i++) {
+		if(i != home && getPartitionSquareDistance(pool->partitions + i, desired) < bestDistance) {
+			othersCouldBeCloser = true;
+			break;
+		}
+	}
+
+	if(!othersCouldBeCloser) {
+		bool taken = bestPartition >= 0 && removeColorFromPartition(pool, homePartition, best);
+		bool rebalance = false;
+
+		if(taken) {
+			rebalance = homePartition->numAvailable < homePartition->rebalanceThreshold;
+			*out = best;
+		}
+
+		pthread_mutex_unlock(&(homePartition->lock));
+		pthread_rwlock_unlock(&(pool->layoutLock));
+
+		if(rebalance) {
+			rebalancePartitions(pool, generation);
+		}
+
+		return taken;
+	}
+
+	pthread_mutex_unlock(&(homePartition->lock));
+
+	RB_ColorSquareDistance searchRadius = bestDistance;
+
+	while(true) {
+		bool searched[pool->numPartitions];
+		RB_ColorSquareDistance closestUnsearched = UINT_FAST32_MAX;
+
+		for(int i = 0; i < pool->numPartitions; i++) {
+			RB_ColorSquareDistance distance = getPartitionSquareDistance(pool->partitions + i, desired);
+			searched[i] = (i == home || distance < searchRadius);
+
+			if(searched[i]) {
+				pthread_mutex_lock(&(pool->partitions[i].lock));
+			} else if(distance < closestUnsearched) {
+				closestUnsearched = distance;
+			}
+		}
+
+		bestDistance = UINT_FAST32_MAX;
+		bestPartition = -1;
+
+		for(int i = 0; i < pool->numPartitions; i++) {
+			RB_Color candidate;
+			RB_ColorSquareDistance candidateDistance;
+
+			if(
+				searched[i] &&
+				findIdealColorInPartition(pool->partitions + i, desired, &candidate, &candidateDistance) &&
+				candidateDistance < bestDistance
+			) {
+				best = candidate;
+				bestDistance = candidateDistance;
+				bestPartition = i;
+			}
+		}
+
+		// A partition that wasn't searched could only beat the best color if it's closer than it.
+		bool isIdeal = bestPartition >= 0 && bestDistance <= closestUnsearched;
+		bool taken = isIdeal && removeColorFromPartition(pool, pool->partitions + bestPartition, best);
+		bool rebalance = false;
+
+		if(taken) {
+			ColorPartition* partition = pool->partitions + bestPartition;
+			rebalance = partition->numAvailable < partition->rebalanceThreshold;
+			*out = best;
+		}
+
+		for(int i = pool->numPartitions - 1; i >= 0; i--) {
+			if(searched[i]) {
+				pthread_mutex_unlock(&(pool->partitions[i].lock));
+			}
+		}
+
+		if(isIdeal || closestUnsearched == UINT_FAST32_MAX) {
+			pthread_rwlock_unlock(&(pool->layoutLock));
+
+			if(rebalance) {
+				rebalancePartitions(pool, generation);
+			}
+
+			return taken;
+		}
+
+		searchRadius = UINT_FAST32_MAX;
+	}
+}
+
+bool RB_takeColorFromPartitionedPool(RB_PartitionedColorPool* pool, RB_Color color) {
+	if(color.r >= pool->rSize || color.g >= pool->gSize || color.b >= pool->bSize) {
+		return false;
+	}
+
+	pthread_rwlock_rdlock(&(pool->layoutLock));
+
+	ColorPartition* partition = pool->partitions + getPartitionIndex(pool, color.r);
+	pthread_mutex_lock(&(partition->lock));
+
+	bool ret = (
+		pool->remaining[getColorRemainingIndex(pool, color)] > 0
+		&& removeColorFromPartition(pool, partition, color)
+	);
+
+	pthread_mutex_unlock(&(partition->lock));
+	pthread_rwlock_unlock(&(pool->layoutLock));
+
+	return ret;
+}
@@ -4,12 +4,21 @@
 #include "headers/RB_ColorPool.h"
 #include "headers/RB_PixelMap.h"
 #include "headers/RB_Display.h"
+#include "headers/RB_MatchSchedule.h"
+#include "headers/RB_GrowthFronts.h"
 //#include "headers/RB_Random.c"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <time.h>
 #include <math.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+// Blank coords with at least this many set neighbours are placed before any other scheduled coord.
+#define RB_MATCH_URGENT_NEIGHBORS 4
 
 
 
@@ -27,6 +36,17 @@ RB_Config* RB_newConfig() {
 	ret->colorResSet = false;
 	ret->windowDimensionsSet = false;
 	ret->seedSet = false;
+	ret->numPaletteRegions = 0;
+	ret->colorMultiplicity = 1;
+	ret->colorPoolTemplate = NULL;
+	ret->takeColorPoolTemplate = false;
+	ret->colorPoolExportPrefix = NULL;
+	ret->queueSampling = RB_QUEUE_SAMPLING_UNIFORM;
+	ret->reservedPixelFraction = 0;
+	ret->bestMatchScheduling = false;
+	ret->numGrowthFronts = 0;
+	ret->frontScheduling = RB_FRONT_SCHEDULING_ROUND_ROBIN;
+	ret->headless = false;
 
 	return ret;
 }
@@ -40,17 +60,20 @@ bool checkColorResAndMapDimCompatibility(
 	RB_ColorChannelSize rRes,
 	RB_ColorChannelSize gRes,
 	RB_ColorChannelSize bRes,
+	RB_ColorCount multiplicity,
 	RB_Size width,
 	RB_Size height
 ) {
-	if(rRes * gRes * bRes != width * height) {
+	unsigned long numColors = (unsigned long) rRes * gRes * bRes * multiplicity;
+
+	if(width * height < 0 || numColors != (unsigned long) (width * height)) {
 		fprintf(
 			stderr,
-			"Error configuring rainbow! width * height must be equal to rRes * gRes * bRes!\n"
-			"width * height == %d * %d == %d\n"
-			"rRes * gRes * bRes == %d * %d * %d == %d\n",
-			width, height, width * height,
-			rRes, gRes, bRes, rRes * gRes * bRes
+			"Error configuring rainbow! width * height must be equal to rRes * gRes * bRes * multiplicity!\n"
+			"width * height == %ld * %ld == %ld\n"
+			"rRes * gRes * bRes * multiplicity == %lu * %lu * %lu * %lu == %lu\n",
+			(long) width, (long) height, (long) (width * height),
+			(unsigned long) rRes, (unsigned long) gRes, (unsigned long) bRes, (unsigned long) multiplicity, numColors
 		);
 		return false;
 	}
@@ -61,7 +84,9 @@ bool checkColorResAndMapDimCompatibility(
 void RB_setColorResolution(RB_Config* config, RB_ColorChannelSize rRes, RB_ColorChannelSize gRes, RB_ColorChannelSize bRes) {
 	if(
 		config->mapDimensionsSet
-		&& !checkColorResAndMapDimCompatibility(rRes, gRes, bRes, config->width, config->height)
+		&& !checkColorResAndMapDimCompatibility(
+			rRes, gRes, bRes, config->colorMultiplicity, config->width, config->height
+		)
 	) {
 		return;
 	}
@@ -90,7 +115,9 @@ void RB_setColorResolution(RB_Config* config, RB_ColorChannelSize rRes, RB_Color
 void RB_setMapDimensions(RB_Config* config, RB_Size width, RB_Size height) {
 	if(
 		config->colorResSet
-		&& !checkColorResAndMapDimCompatibility(config->rRes, config->gRes, config->bRes, width, height)
+		&& !checkColorResAndMapDimCompatibility(
+			config->rRes, config->gRes, config->bRes, config->colorMultiplicity, width, height
+		)
 	) {
 		return;
 	}
@@ -105,13 +132,13 @@ void RB_setMapDimensions(RB_Config* config, RB_Size width, RB_Size height) {
 		return;
 	}
 
-	if((RB_MAXIMUM_POSSIBLE_NUMBER_OF_COLORS / width) < height) {
+	if((RB_MAXIMUM_POSSIBLE_NUMBER_OF_PIXELS / width) < height) {
 		fprintf(
 			stderr,
-			"Error setting map dimensions! width * height must be less than %d!\n"
-			"width = %d, height = %d\n",
-			RB_MAXIMUM_POSSIBLE_NUMBER_OF_COLORS,
-			width, height
+			"Error setting map dimensions! width * height must be at most %d!\n"
+			"width = %ld, height = %ld\n",
+			RB_MAXIMUM_POSSIBLE_NUMBER_OF_PIXELS,
+			(long) width, (long) height
 		);
 		return;
 	}
@@ -121,6 +148,30 @@ void RB_setMapDimensions(RB_Config* config, RB_Size width, RB_Size height) {
 	config->mapDimensionsSet = true;
 }
 
+void RB_setColorMultiplicity(RB_Config* config, RB_ColorCount multiplicity) {
+	if(multiplicity < 1 || multiplicity > RB_MAXIMUM_POSSIBLE_NUMBER_OF_PIXELS / RB_MAXIMUM_POSSIBLE_NUMBER_OF_COLORS) {
+		fprintf(
+			stderr,
+			"Error setting color multiplicity! Multiplicity must be between 1 and %d, inclusive.\n"
+			"multiplicity = %d\n",
+			RB_MAXIMUM_POSSIBLE_NUMBER_OF_PIXELS / RB_MAXIMUM_POSSIBLE_NUMBER_OF_COLORS,
+			multiplicity
+		);
+		return;
+	}
+
+	if(
+		config->mapDimensionsSet && config->colorResSet
+		&& !checkColorResAndMapDimCompatibility(
+			config->rRes, config->gRes, config->bRes, multiplicity, config->width, config->height
+		)
+	) {
+		return;
+	}
+
+	config->colorMultiplicity = multiplicity;
+}
+
 void RB_setWindowDimensions(RB_Config* config, int wWidth, int wHeight) {
 	if(wWidth < 1 || wHeight < 1) {
 		fprintf(
@@ -142,6 +193,104 @@ void RB_setRandomSeed(RB_Config* config, uint32_t seed) {
 	config->seedSet = true;
 }
 
+void RB_addPaletteRegion(RB_Config* config, RB_Coord mapMin, RB_Coord mapMax, RB_Color colorMin, RB_Color colorMax) {
+	if(config->numPaletteRegions >= RB_MAXIMUM_PALETTE_REGIONS) {
+		fprintf(
+			stderr,
+			"Error adding palette region! There can be at most %d palette regions.\n",
+			RB_MAXIMUM_PALETTE_REGIONS
+		);
+		return;
+	}
+
+	if(
+		mapMin.x > mapMax.x || mapMin.y > mapMax.y
+		|| colorMin.r > colorMax.r || colorMin.g > colorMax.g || colorMin.b > colorMax.b
+	) {
+		fprintf(
+			stderr,
+			"Error adding palette region! Each minimum corner must be less than or equal to its maximum corner.\n"
+			"mapMin = (%ld, %ld), mapMax = (%ld, %ld)\n"
+			"colorMin = (%d, %d, %d), colorMax = (%d, %d, %d)\n",
+			(long) mapMin.x, (long) mapMin.y, (long) mapMax.x, (long) mapMax.y,
+			colorMin.r, colorMin.g, colorMin.b, colorMax.r, colorMax.g, colorMax.b
+		);
+		return;
+	}
+
+	config->paletteRegions[config->numPaletteRegions] = (RB_PaletteRegion) {
+		.mapMin = mapMin,
+		.mapMax = mapMax,
+		.colorMin = colorMin,
+		.colorMax = colorMax
+	};
+	config->numPaletteRegions++;
+}
+
+void RB_setColorPoolTemplate(RB_Config* config, RB_ColorPool* pool) {
+	config->colorPoolTemplate = pool;
+}
+
+void RB_setColorPoolExport(RB_Config* config, const char* pathPrefix, RB_Size interval, int maxDetailedDepth) {
+	if(pathPrefix != NULL && interval < 1) {
+		fprintf(stderr, "Error setting color pool export: the interval must be at least 1!\n");
+		return;
+	}
+
+	config->colorPoolExportPrefix = pathPrefix;
+	config->colorPoolExportInterval = interval;
+	config->colorPoolExportDetailDepth = maxDetailedDepth;
+}
+
+void RB_setQueueSampling(RB_Config* config, RB_QueueSampling sampling) {
+	config->queueSampling = sampling;
+}
+
+void RB_setReservedPixelFraction(RB_Config* config, double fraction) {
+	if(fraction < 0 || fraction > 0.5) {
+		fprintf(stderr, "Error setting reserved pixel fraction: %f is not between 0 and 0.5!\n", fraction);
+		return;
+	}
+
+	config->reservedPixelFraction = fraction;
+}
+
+void RB_setBestMatchScheduling(RB_Config* config, bool enabled) {
+	config->bestMatchScheduling = enabled;
+}
+
+int RB_addGrowthFront(RB_Config* config, const char* name, uint32_t weight) {
+	if(config->numGrowthFronts >= RB_MAXIMUM_GROWTH_FRONTS) {
+		fprintf(
+			stderr,
+			"Error adding growth front! There can be at most %d growth fronts.\n",
+			RB_MAXIMUM_GROWTH_FRONTS
+		);
+		return -1;
+	}
+
+	if(name == NULL || weight < 1) {
+		fprintf(stderr, "Error adding growth front! Every front needs a name and a weight of at least 1.\n");
+		return -1;
+	}
+
+	config->growthFronts[config->numGrowthFronts] = (RB_GrowthFront) {
+		.name = name,
+		.weight = weight
+	};
+	config->numGrowthFronts++;
+
+	return config->numGrowthFronts - 1;
+}
+
+void RB_setFrontScheduling(RB_Config* config, RB_FrontScheduling scheduling) {
+	config->frontScheduling = scheduling;
+}
+
+void RB_setHeadless(RB_Config* config, bool headless) {
+	config->headless = headless;
+}
+
 
 RB_Data* RB_init(RB_Config* config) {
 	if(!config->colorResSet) {
@@ -156,7 +305,7 @@ RB_Data* RB_init(RB_Config* config) {
 		width = config->width;
 		height = config->height;
 	} else {
-		RB_Size numPixels = config->rRes * config->gRes * config->bRes;
+		RB_Size numPixels = config->rRes * config->gRes * config->bRes * config->colorMultiplicity;
 		RB_Size potentialWidth = (RB_Size) sqrt(numPixels);
 		while(potentialWidth * (numPixels / potentialWidth) != numPixels) {
 			potentialWidth++;
@@ -175,11 +324,13 @@ RB_Data* RB_init(RB_Config* config) {
 	printf(
 		"Initializing Rainbow Image Generator.\n"
 		"| Color Resolutions: %d, %d, %d.\n"
+		"| Color Multiplicity: %d.\n"
 		"| Pixel Map Dimensions: %d, %d.\n"
 		"| Total pixels: %d.\n"
 		"| Display Window Dimensions: %d, %d.\n"
 		"| Seed: %u.\n",
 		config->rRes, config->gRes, config->bRes,
+		config->colorMultiplicity,
 		width, height,
 		numPixels,
 		wWidth, wHeight,
@@ -197,30 +348,77 @@ RB_Data* RB_init(RB_Config* config) {
 	}
 
 	ret->assignmentQueue = NULL;
+	ret->growthFronts = NULL;
 	ret->colorPool = NULL;
 	ret->pixelMap = NULL;
 	ret->display = NULL;
+	ret->matchSchedule = NULL;
+	ret->numPixelsGenerated = 0;
 
 	ret->config = (RB_Config) {
 		.rRes = config->rRes,
 		.gRes = config->gRes,
 		.bRes = config->bRes,
+		.colorMultiplicity = config->colorMultiplicity,
 		.width = width,
 		.height = height,
 		.windowWidth = wWidth,
 		.windowHeight = wHeight,
-		.seed = seed
+		.seed = seed,
+		.numPaletteRegions = config->numPaletteRegions,
+		.colorPoolExportPrefix = config->colorPoolExportPrefix,
+		.colorPoolExportInterval = config->colorPoolExportInterval,
+		.colorPoolExportDetailDepth = config->colorPoolExportDetailDepth,
+		.queueSampling = config->queueSampling,
+		.reservedPixelFraction = config->reservedPixelFraction,
+		.bestMatchScheduling = config->bestMatchScheduling,
+		.numGrowthFronts = config->numGrowthFronts,
+		.frontScheduling = config->frontScheduling,
+		.headless = config->headless
 	};
-	
-	ret->assignmentQueue = RB_createAssignmentQueue(numPixels, width, height);
 
-	if(ret->assignmentQueue == NULL) {
-		fprintf(stderr, "Failed to initialize Assignment Queue!\n");
-		RB_free(ret);
-		return NULL;
+	for(int i = 0; i < config->numPaletteRegions; i++) {
+		ret->config.paletteRegions[i] = config->paletteRegions[i];
+	}
+
+	for(int i = 0; i < config->numGrowthFronts; i++) {
+		ret->config.growthFronts[i] = config->growthFronts[i];
+	}
+
+	if(config->numGrowthFronts > 0) {
+		ret->growthFronts = RB_createGrowthFronts(
+			width, height,
+			config->growthFronts, config->numGrowthFronts,
+			config->frontScheduling, config->queueSampling
+		);
+
+		if(ret->growthFronts == NULL) {
+			fprintf(stderr, "Failed to initialize Growth Fronts!\n");
+			RB_free(ret);
+			return NULL;
+		}
+	} else {
+		ret->assignmentQueue = RB_createAssignmentQueue(numPixels, width, height);
+
+		if(
+			ret->assignmentQueue == NULL
+			|| !RB_setAssignmentQueueSampling(ret->assignmentQueue, config->queueSampling)
+		) {
+			fprintf(stderr, "Failed to initialize Assignment Queue!\n");
+			RB_free(ret);
+			return NULL;
+		}
 	}
 
-	ret->colorPool = RB_createColorPool(config->rRes, config->gRes, config->bRes);
+	if(config->colorPoolTemplate != NULL && config->takeColorPoolTemplate) {
+		ret->colorPool = config->colorPoolTemplate;
+	} else if(config->colorPoolTemplate != NULL) {
+		ret->colorPool = RB_cloneColorPool(config->colorPoolTemplate);
+	} else {
+		ret->colorPool = RB_createColorPoolWithMultiplicity(
+			config->rRes, config->gRes, config->bRes, config->colorMultiplicity
+		);
+	}
 
 	if(ret->colorPool == NULL) {
 		fprintf(stderr, "Failed to initialize Color Pool!\n");
@@ -228,6 +426,10 @@ RB_Data* RB_init(RB_Config* config) {
 		return NULL;
 	}
 
+	if(config->colorPoolExportPrefix != NULL) {
+		RB_setColorPoolExpansionCounting(ret->colorPool, true);
+	}
+
 	ret->pixelMap = RB_createPixelMap(width, height, config->rRes, config->gRes, config->bRes);
 
 	if(ret->pixelMap == NULL) {
@@ -236,16 +438,30 @@ RB_Data* RB_init(RB_Config* config) {
 		return NULL;
 	}
 
-	ret->display = RB_createDisplay(
-		wWidth, wHeight,
-		width, height,
-		config->rRes, config->gRes, config->bRes
-	);
+	RB_reservePixels(ret->pixelMap, config->reservedPixelFraction);
 
-	if(ret->display == NULL) {
-		fprintf(stderr, "Failed to initialize Display!\n");
-		RB_free(ret);
-		return NULL;
+	if(config->bestMatchScheduling) {
+		ret->matchSchedule = RB_createMatchSchedule(width, height);
+
+		if(ret->matchSchedule == NULL) {
+			fprintf(stderr, "Failed to initialize Match Schedule!\n");
+			RB_free(ret);
+			return NULL;
+		}
+	}
+
+	if(!config->headless) {
+		ret->display = RB_createDisplay(
+			wWidth, wHeight,
+			width, height,
+			config->rRes, config->gRes, config->bRes
+		);
+
+		if(ret->display == NULL) {
+			fprintf(stderr, "Failed to initialize Display!\n");
+			RB_free(ret);
+			return NULL;
+		}
 	}
 
 	return ret;
@@ -255,13 +471,157 @@ void RB_free(RB_Data* data) {
 	if(data != NULL) {
 		printf("Freeing RB_Data!\n");
 		RB_freeAssignmentQueue(data->assignmentQueue);
+		RB_freeGrowthFronts(data->growthFronts);
 		RB_freeColorPool(data->colorPool);
 		RB_freePixelMap(data->pixelMap);
 		RB_freeDisplay(data->display);
+		RB_freeMatchSchedule(data->matchSchedule);
 		free(data);
 	}
 }
 
+// Runs one job. Returns false if it failed.
+bool runJob(const RB_Config* config, int jobIndex, RB_JobFunction job, void* userData) {
+	RB_Config jobConfig = *config;
+	RB_setRandomSeed(&jobConfig, config->seed + jobIndex);
+
+	RB_Data* data = RB_init(&jobConfig);
+	bool succeeded = data != NULL && job(data, jobIndex, userData);
+
+	if(!succeeded) {
+		fprintf(stderr, "Job %d failed!\n", jobIndex);
+	}
+
+	RB_free(data);
+	return succeeded;
+}
+
+// How often waitForJob checks on the running jobs. Jobs take far longer than this, so polling costs next to nothing.
+#define RB_JOB_POLL_NANOSECONDS 1000000
+
+/*
+Waits for one of the running jobs to finish and removes it from the list. Returns 1 if it failed, or 0 if it didn't.
+Only the jobs' own pids are waited on, so any children the caller forked itself are left for the caller to reap.
+*/
+int waitForJob(pid_t* running, int* numRunning) {
+	const struct timespec pollInterval = { .tv_sec = 0, .tv_nsec = RB_JOB_POLL_NANOSECONDS };
+
+	while(true) {
+		for(int i = 0; i < *numRunning; i++) {
+			pid_t jobPid = running[i];
+			int status;
+			pid_t pid = waitpid(jobPid, &status, WNOHANG);
+
+			if(pid == 0 || (pid < 0 && errno == EINTR)) {
+				continue;
+			}
+
+			(*numRunning)--;
+			running[i] = running[*numRunning];
+
+			if(pid < 0) {
+				fprintf(stderr, "Error running jobs: lost track of the job in process %ld!\n", (long) jobPid);
+				return 1;
+			}
+
+			return (WIFEXITED(status) && WEXITSTATUS(status) == 0)? 0 : 1;
+		}
+
+		nanosleep(&pollInterval, NULL);
+	}
+}
+
+/*
+Every job gets a process of its own, forked from this one once the template has been built. RB_init takes the
+inherited template as the job's pool instead of cloning it, since each process has its own copy-on-write copy anyway,
+so the only pages of the pool that ever get copied are the ones the job writes to. Forking a process is much cheaper
+than cloning a full-size pool.
+*/
+int RB_runForkedJobs(RB_Config* config, int numJobs, int numWorkers, RB_JobFunction job, void* userData) {
+	if(numWorkers < 1) {
+		fprintf(stderr, "Error running jobs: there must be at least one worker!\n");
+		return -1;
+	}
+
+	if(numWorkers > numJobs) {
+		numWorkers = numJobs;
+	}
+
+	RB_Config jobConfig = *config;
+	// The jobs run unattended, possibly many at once and on machines without a display.
+	jobConfig.headless = true;
+
+	if(!jobConfig.seedSet) {
+		RB_setRandomSeed(&jobConfig, time(NULL));
+	}
+
+	// Build the pool before forking so it only gets built once.
+	RB_ColorPool* builtTemplate = NULL;
+
+	if(jobConfig.colorPoolTemplate == NULL) {
+		builtTemplate = RB_createColorPoolWithMultiplicity(
+			jobConfig.rRes, jobConfig.gRes, jobConfig.bRes, jobConfig.colorMultiplicity
+		);
+
+		if(builtTemplate == NULL) {
+			fprintf(stderr, "Error running jobs: failed to build the color pool!\n");
+			return -1;
+		}
+
+		RB_setColorPoolTemplate(&jobConfig, builtTemplate);
+	}
+
+	pid_t* running = (pid_t*) malloc(sizeof(pid_t) * numWorkers);
+
+	if(running == NULL) {
+		RB_freeColorPool(builtTemplate);
+		return -1;
+	}
+
+	int numFailed = 0;
+	int numRunning = 0;
+
+	for(int jobIndex = 0; jobIndex < numJobs; jobIndex++) {
+		if(numRunning == numWorkers) {
+			numFailed += waitForJob(running, &numRunning);
+		}
+
+		// Anything still buffered would be printed once by every job.
+		fflush(stdout);
+		fflush(stderr);
+
+		pid_t pid = fork();
+
+		if(pid == 0) {
+			jobConfig.takeColorPoolTemplate = true;
+			bool succeeded = runJob(&jobConfig, jobIndex, job, userData);
+			fflush(stdout);
+			_exit(succeeded? 0 : 1);
+		}
+
+		if(pid < 0) {
+			fprintf(stderr, "Error running jobs: fork failed! Running the remaining jobs in this process.\n");
+			// The template has to outlive these jobs, so they clone it.
+			for(int j = jobIndex; j < numJobs; j++) {
+				numFailed += runJob(&jobConfig, j, job, userData)? 0 : 1;
+			}
+			break;
+		}
+
+		running[numRunning] = pid;
+		numRunning++;
+	}
+
+	while(numRunning > 0) {
+		numFailed += waitForJob(running, &numRunning);
+	}
+
+	free(running);
+	RB_freeColorPool(builtTemplate);
+
+	return numFailed;
+}
+
 
 RB_Color RB_getRandomColor(RB_Data* data) {
 	return (RB_Color) {
@@ -271,6 +631,10 @@ RB_Color RB_getRandomColor(RB_Data* data) {
 	};
 }
 
+RB_Color RB_getRandomAvailableColor(RB_Data* data) {
+	return RB_sampleRandomAvailableColor(data->colorPool);
+}
+
 RB_Coord RB_getRandomCoord(RB_Data* data) {
 	return (RB_Coord) {
 		.x = rand() % data->config.width,
@@ -278,41 +642,312 @@ RB_Coord RB_getRandomCoord(RB_Data* data) {
 	};
 }
 
-void RB_setCoordColor(RB_Data* data, RB_Coord coord, RB_Color color) {
+RB_Color RB_findIdealAvailableColorForCoord(RB_Data* data, RB_Coord coord, RB_Color preferredColor) {
+	for(int i = 0; i < data->config.numPaletteRegions; i++) {
+		RB_PaletteRegion* region = &(data->config.paletteRegions[i]);
+
+		if(
+			coord.x < region->mapMin.x || coord.x > region->mapMax.x
+			|| coord.y < region->mapMin.y || coord.y > region->mapMax.y
+		) {
+			continue;
+		}
+
+		RB_Color ret;
+		if(RB_findIdealAvailableColorInBox(data->colorPool, preferredColor, region->colorMin, region->colorMax, &ret)) {
+			return ret;
+		}
+
+		// The region's colors have run out.
+		break;
+	}
+
+	return RB_findIdealAvailableColor(data->colorPool, preferredColor);
+}
+
+// The growth front's queue, or the only queue if there are no growth fronts.
+RB_AssignmentQueue* getFrontQueue(RB_Data* data, int front) {
+	if(data->growthFronts == NULL) {
+		return data->assignmentQueue;
+	}
+
+	return RB_getGrowthFrontQueue(data->growthFronts, front);
+}
+
+// The queue that holds the coord, or that would if the coord were queued. Coords that were queued without a front,
+// like released reserved pixels, are in front 0's queue.
+RB_AssignmentQueue* getCoordQueue(RB_Data* data, RB_Coord coord) {
+	if(data->growthFronts == NULL) {
+		return data->assignmentQueue;
+	}
+
+	int front = RB_getCoordGrowthFront(data->growthFronts, coord);
+	return getFrontQueue(data, (front < 0)? 0 : front);
+}
+
+// Everything RB_setCoordColor does except queueing the resulting coords. Returns false if the pixel was already set.
+bool setPixelColor(RB_Data* data, RB_Coord coord, RB_Color color) {
 	RB_Pixel* toSet = RB_getPixel(data->pixelMap, coord);
+	RB_AssignmentQueue* queue = getCoordQueue(data, coord);
 
 	if(toSet->status == RB_PIXEL_SET) {
 		fprintf(
 			stderr,
 			"Attempting to set Pixel at (%d,%d) even though it is already set!\n"
 			"\tQueue size: %d\n",
-			toSet->loc.x,
-			toSet->loc.y,
-			RB_getQueueSize(data->assignmentQueue)
+			coord.x,
+			coord.y,
+			RB_getQueueSize(queue)
 		);
-		return;
+		return false;
+	}
+	if(RB_coordIsInQueue(queue, coord)) {
+		RB_removeCoordFromAssignmentQueue(queue, coord);	
+	} else {
+		RB_markSeedInAssignmentQueue(queue, coord);
 	}
-	if(RB_coordIsInQueue(data->assignmentQueue, toSet->loc)) {
-		RB_removeCoordFromAssignmentQueue(data->assignmentQueue, toSet->loc);	
+	if(data->matchSchedule != NULL) {
+		RB_unscheduleCoord(data->matchSchedule, coord);
 	}
 	RB_removeColorFromPool(data->colorPool, color);
 
 	toSet->color = color;
 	toSet->status = RB_PIXEL_SET;
 
-	RB_setDisplayedPixelColor(data->display, toSet->loc, color);
+	RB_setDisplayedPixelColor(data->display, coord, color);
+
+	return true;
+}
+
+/*
+The key a blank coord is scheduled with, given how far its preferred color is from its match. Coords with many set
+neighbours are the ones that turn into badly matched holes if they're left for later, so the key shrinks fourfold
+with every set neighbour, and coords with at least RB_MATCH_URGENT_NEIGHBORS are placed before anything else.
+*/
+uint32_t getMatchKey(RB_Data* data, RB_Coord coord, RB_ColorSquareDistance distance) {
+	int numSetNeighbors = RB_countSetPixelsAround(data->pixelMap, coord);
+
+	if(numSetNeighbors >= RB_MATCH_URGENT_NEIGHBORS) {
+		return 0;
+	}
+
+	// The largest square distance is 3 * 255^2, so this can't overflow.
+	return (uint32_t) ((distance << 8) >> (2 * numSetNeighbors));
+}
+
+/*
+The coord's neighbours that are queued have a new set neighbour, so their preferred colors may have changed, and
+their cached matches are dropped. If a neighbour's last match is still available, its distance to the new preferred
+color is an upper bound on the new match distance, which is cheap to get and good enough to schedule it with. Only
+neighbours without one fall back to the estimate, which puts them near the top so they get matched right away.
+*/
+void rescheduleNeighbors(RB_Data* data, RB_Coord coord, uint32_t estimate) {
+	if(data->matchSchedule == NULL) {
+		return;
+	}
+
+	for(RB_Size x = coord.x - 1; x <= coord.x + 1; x++) {
+		for(RB_Size y = coord.y - 1; y <= coord.y + 1; y++) {
+			RB_Coord neighbor = {.x = x, .y = y};
+
+			if(
+				x >= 0 && x < data->config.width && y >= 0 && y < data->config.height
+				&& RB_coordIsInQueue(getCoordQueue(data, neighbor), neighbor)
+			) {
+				uint32_t key = estimate;
+				RB_Color lastColor;
+
+				if(
+					RB_getLastScheduledColor(data->matchSchedule, neighbor, &lastColor)
+					&& RB_colorIsAvailableInPool(data->colorPool, lastColor)
+				) {
+					RB_Color preferredColor = RB_determinePreferredCoordColor(data->pixelMap, neighbor);
+					key = getMatchKey(data, neighbor, RB_getColorSquareDistance(preferredColor, lastColor));
+				}
+
+				RB_scheduleUnmatchedCoord(data->matchSchedule, neighbor, key);
+			}
+		}
+	}
+}
+
+// Gives the coord to the front, unless it already belongs to one. The front it already belongs to gets merged with
+// this one by claimCoordsAround once the pixel is set.
+void claimCoordForFront(RB_Data* data, RB_Coord coord, int front) {
+	if(data->growthFronts != NULL && RB_getCoordGrowthFront(data->growthFronts, coord) < 0) {
+		RB_setCoordGrowthFront(data->growthFronts, coord, front);
+	}
+}
+
+/*
+Called after the front set the center and queued the coords around it. The coords it queued don't belong to any front
+yet, so they're given to it. Any other coord around the center that belongs to another front means the two fronts
+have collided, so they get merged.
+*/
+void claimCoordsAround(RB_Data* data, RB_Coord center, int front) {
+	if(data->growthFronts == NULL) {
+		return;
+	}
+
+	front = RB_findGrowthFront(data->growthFronts, front);
+
+	for(RB_Size x = center.x - 1; x <= center.x + 1; x++) {
+		for(RB_Size y = center.y - 1; y <= center.y + 1; y++) {
+			RB_Coord neighbor = {.x = x, .y = y};
+
+			if(x < 0 || x >= data->config.width || y < 0 || y >= data->config.height) {
+				continue;
+			}
+
+			int neighborFront = RB_getCoordGrowthFront(data->growthFronts, neighbor);
+
+			if(neighborFront < 0) {
+				if(RB_coordIsInQueue(RB_getGrowthFrontQueue(data->growthFronts, front), neighbor)) {
+					RB_setCoordGrowthFront(data->growthFronts, neighbor, front);
+				}
+			} else if(neighborFront != front) {
+				front = RB_mergeGrowthFronts(data->growthFronts, data->pixelMap, front, neighborFront);
+			}
+		}
+	}
+}
+
+// RB_setCoordColorInFront, but the neighbours it reschedules without a bound are placed at the estimated key.
+void setCoordColorWithEstimate(RB_Data* data, RB_Coord coord, RB_Color color, uint32_t estimate, int front) {
+	claimCoordForFront(data, coord, front);
+
+	if(setPixelColor(data, coord, color)) {
+		RB_addResultantCoordsToQueue(data->pixelMap, getFrontQueue(data, front), coord);
+		claimCoordsAround(data, coord, front);
+		rescheduleNeighbors(data, coord, estimate);
+	}
+}
+
+void RB_setCoordColor(RB_Data* data, RB_Coord coord, RB_Color color) {
+	RB_setCoordColorInFront(data, 0, coord, color);
+}
+
+void RB_setCoordColorInFront(RB_Data* data, int front, RB_Coord coord, RB_Color color) {
+	if(front < 0 || front >= ((data->growthFronts == NULL)? 1 : data->config.numGrowthFronts)) {
+		fprintf(stderr, "Error setting coord color: there is no growth front %d!\n", front);
+		return;
+	}
+
+	// Pixels set from outside are usually seeds, so their neighbours get matched before anything else.
+	setCoordColorWithEstimate(data, coord, color, 0, front);
+}
+
+void RB_setCoordColors(RB_Data* data, const RB_Coord* coords, const RB_Color* colors, RB_Size numCoords) {
+	for(RB_Size i = 0; i < numCoords; i++) {
+		claimCoordForFront(data, coords[i], 0);
+		setPixelColor(data, coords[i], colors[i]);
+	}
+
+	// Pixels that were already set get marked again, which doesn't change anything.
+	RB_addResultantCoordsOfBatchToQueue(data->pixelMap, getFrontQueue(data, 0), coords, numCoords);
+
+	for(RB_Size i = 0; i < numCoords; i++) {
+		claimCoordsAround(data, coords[i], 0);
+		rescheduleNeighbors(data, coords[i], 0);
+	}
+}
+
+void exportColorPoolTree(RB_Data* data) {
+	char path[1024];
+	snprintf(path, sizeof(path), "%s%ld.json", data->config.colorPoolExportPrefix, (long) data->numPixelsGenerated);
+
+	FILE* file = fopen(path, "w");
+
+	if(file == NULL) {
+		fprintf(stderr, "Error exporting color pool tree: could not open %s!\n", path);
+		return;
+	}
+
+	if(!RB_exportColorPoolTree(data->colorPool, file, data->config.colorPoolExportDetailDepth)) {
+		fprintf(stderr, "Error exporting color pool tree: could not write %s!\n", path);
+	}
+
+	fclose(file);
+}
+
+/*
+Pops the schedule until it finds a coord whose key is no larger than any other scheduled coord's. Matches can only
+get worse while a coord's neighbourhood stays the same, because colors are only ever taken from the pool. So a cached
+match whose color is still available is exact, and one whose color was taken is a lower bound that gets rematched and
+pushed back. Coords that were rescheduled since their last match sit at an upper bound or an estimate instead, so the
+result is only approximately the best. Returns false if the schedule ran dry.
+*/
+bool chooseBestScheduledMatch(RB_Data* data, RB_ScheduledMatch* out) {
+	while(RB_popScheduledMatch(data->matchSchedule, out)) {
+		if(out->hasColor && RB_colorIsAvailableInPool(data->colorPool, out->color)) {
+			return true;
+		}
+
+		RB_Color preferredColor = RB_determinePreferredCoordColor(data->pixelMap, out->coord);
+		out->color = RB_findIdealAvailableColorForCoord(data, out->coord, preferredColor);
+		out->key = getMatchKey(data, out->coord, RB_getColorSquareDistance(preferredColor, out->color));
+		out->hasColor = true;
+
+		// Don't bother pushing it back if it would just be popped again.
+		if(out->key <= RB_peekScheduledKey(data->matchSchedule)) {
+			return true;
+		}
+
+		RB_scheduleMatch(data->matchSchedule, out->coord, out->color, out->key);
+	}
+
+	return false;
+}
+
+bool frontierIsEmpty(RB_Data* data) {
+	if(data->growthFronts != NULL) {
+		return RB_growthFrontsAreEmpty(data->growthFronts);
+	}
 
-	RB_addResultantCoordsToQueue(data->pixelMap, data->assignmentQueue, toSet->loc);
+	return RB_isQueueEmpty(data->assignmentQueue);
+}
+
+// With growth fronts, the reserved pixels are released into front 0, or the front it was merged into. They don't
+// belong to it until they're set.
+bool releaseReservedPixels(RB_Data* data) {
+	return RB_releaseReservedPixels(data->pixelMap, getFrontQueue(data, 0));
 }
 
 bool RB_generateNextPixel(RB_Data* data) {
-	if(RB_isQueueEmpty(data->assignmentQueue)) {
+	if(frontierIsEmpty(data) && !releaseReservedPixels(data)) {
 		return false;
 	}
 
-	RB_Coord nextCoord = RB_chooseCoordFromAssignmentQueue(data->assignmentQueue);
-	RB_Color preferredColor = RB_determinePreferredCoordColor(data->pixelMap, nextCoord);
-	RB_Color idealColor = RB_findIdealAvailableColor(data->colorPool, preferredColor);
+	RB_Coord nextCoord;
+	RB_Color idealColor;
+	uint32_t idealKey = 0;
+	int front = 0;
+	RB_ScheduledMatch match;
+
+	if(data->matchSchedule != NULL && chooseBestScheduledMatch(data, &match)) {
+		nextCoord = match.coord;
+		idealColor = match.color;
+		idealKey = match.key;
+
+		// Scheduled coords can be queued without a front, like released reserved pixels, and those are in front 0's.
+		if(data->growthFronts != NULL) {
+			front = RB_getCoordGrowthFront(data->growthFronts, nextCoord);
+			front = (front < 0)? 0 : front;
+		}
+	} else {
+		if(data->growthFronts != NULL) {
+			front = RB_chooseGrowthFront(data->growthFronts);
+
+			// Every front's queue is empty.
+			if(front < 0) {
+				return false;
+			}
+		}
+
+		nextCoord = RB_chooseCoordFromAssignmentQueue(getFrontQueue(data, front));
+		RB_Color preferredColor = RB_determinePreferredCoordColor(data->pixelMap, nextCoord);
+		idealColor = RB_findIdealAvailableColorForCoord(data, nextCoord, preferredColor);
+	}
 
 	// RB_Coord nextCoord = RB_chooseCoordFromAssignmentQueue(data->assignmentQueue);
 	// RB_Color preferredColor_raw = RB_determinePreferredCoordColor(data->pixelMap, nextCoord);
@@ -336,7 +971,22 @@ bool RB_generateNextPixel(RB_Data* data) {
 	// RB_Color idealColor = RB_findIdealAvailableColor(data->colorPool, preferredColor);
 
 
-	RB_setCoordColor(data, nextCoord, idealColor);
+	setCoordColorWithEstimate(data, nextCoord, idealColor, idealKey, front);
+	data->numPixelsGenerated++;
+
+	// The main fill is done once the queue runs dry. Only then do the reserved pixels get their turn.
+	if(frontierIsEmpty(data)) {
+		releaseReservedPixels(data);
+	}
+
+	bool hasPixelsLeft = !frontierIsEmpty(data);
+
+	if(
+		data->config.colorPoolExportPrefix != NULL &&
+		(data->numPixelsGenerated % data->config.colorPoolExportInterval == 0 || !hasPixelsLeft)
+	) {
+		exportColorPoolTree(data);
+	}
 
-	return !RB_isQueueEmpty(data->assignmentQueue);
+	return hasPixelsLeft;
 }
\ No newline at end of file
@@ -0,0 +1,378 @@
+#include "headers/RB_AssignmentQueue.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+/*
+An assignmentQueue that never uses rand(), and chooses the queued coord that's the fewest steps away from a seed,
+counting diagonal steps as one. The image grows outwards from every seed at the same speed, in rings.
+
+A coord's distance is worked out when it's queued: one more than the smallest distance of its already-set neighbours.
+Removing a coord from the queue means it's about to be set, so the queue remembers its distance from then on. Seeds
+are set without ever being queued, so they have to be reported with RB_markSeedInAssignmentQueue.
+
+Coords are kept in a bucket queue: one bucket for each distance, each an unordered array of RB_PixelIndexes with O(1)
+swap-removal.
+Distances grow as the image does, so the lowest non-empty bucket only ever moves forward, except when a new seed is
+marked partway through. That keeps every operation O(1) amortized.
+
+The distance takes the place of priorityIndex, which is ignored. There's no randomness to weigh or bias, so
+only RB_QUEUE_SAMPLING_UNIFORM is supported and coord weights are ignored.
+*/
+
+#define RB_QUEUE_INDEX_UNQUEUED -1
+// The distance of a coord that hasn't been queued or marked as a seed yet.
+#define RB_SEED_DISTANCE_UNKNOWN -1
+// The number of coords a bucket has room for when it's first used.
+#define RB_QUEUE_INITIAL_BUCKET_CAPACITY 16
+
+// The tables indexed by pixel index, which RB_createSharedAssignmentQueue shares between queues. Queues that share
+// coordDistances measure from every set coord, whichever queue it came from.
+typedef struct {
+	int numQueues;
+
+	int32_t* coordIndexes;
+	int32_t* coordDistances;
+} PixelTables;
+
+struct RB_AssignmentQueue_s {
+	// One bucket for every possible distance.
+	RB_PixelIndex** bucketPixels;
+	RB_Size* bucketLens;
+	RB_Size* bucketCapacities;
+	RB_Size numBuckets;
+	// No bucket below this one has any coords.
+	RB_Size lowestBucket;
+
+	RB_Size coordLen;
+	RB_Size maxCoordLen;
+
+	// The index of each queued coord within its bucket, or RB_QUEUE_INDEX_UNQUEUED, indexed by pixel index.
+	int32_t* coordIndexes;
+	// The distance of each queued or set coord, or RB_SEED_DISTANCE_UNKNOWN, indexed by pixel index. A queued coord is
+	// in this bucket.
+	int32_t* coordDistances;
+	PixelTables* pixelTables;
+	RB_Size xRange;
+	RB_Size yRange;
+};
+
+PixelTables* createPixelTables(RB_Size xRange, RB_Size yRange) {
+	PixelTables* ret = malloc(
+		sizeof(PixelTables)
+		+ (sizeof(int32_t) * xRange * yRange * 2)
+	);
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	ret->numQueues = 0;
+	ret->coordIndexes = (int32_t*) (ret + 1);
+	ret->coordDistances = ret->coordIndexes + (xRange * yRange);
+
+	for(RB_Size i = 0; i < xRange * yRange; i++) {
+		ret->coordIndexes[i] = RB_QUEUE_INDEX_UNQUEUED;
+		ret->coordDistances[i] = RB_SEED_DISTANCE_UNKNOWN;
+	}
+
+	return ret;
+}
+
+RB_AssignmentQueue* createQueueWithPixelTables(RB_Size size, RB_Size xRange, RB_Size yRange, PixelTables* tables) {
+	// No coord can be more steps from a seed than the longer side of the canvas.
+	RB_Size numBuckets = ((xRange > yRange)? xRange : yRange) + 1;
+
+	RB_AssignmentQueue* ret = malloc(sizeof(RB_AssignmentQueue));
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	ret->bucketPixels = (RB_PixelIndex**) calloc(numBuckets, sizeof(RB_PixelIndex*));
+	ret->bucketLens = (RB_Size*) calloc(numBuckets, sizeof(RB_Size));
+	ret->bucketCapacities = (RB_Size*) calloc(numBuckets, sizeof(RB_Size));
+
+	if(ret->bucketPixels == NULL || ret->bucketLens == NULL || ret->bucketCapacities == NULL) {
+		free(ret->bucketPixels);
+		free(ret->bucketLens);
+		free(ret->bucketCapacities);
+		free(ret);
+		return NULL;
+	}
+
+	ret->numBuckets = numBuckets;
+	ret->lowestBucket = 0;
+
+	ret->maxCoordLen = size;
+	ret->coordLen = 0;
+
+	ret->coordIndexes = tables->coordIndexes;
+	ret->coordDistances = tables->coordDistances;
+	ret->pixelTables = tables;
+	ret->xRange = xRange;
+	ret->yRange = yRange;
+
+	tables->numQueues++;
+
+	return ret;
+}
+
+// Allocates an assignmentQueue capable of storing the specified number of pixels.
+RB_AssignmentQueue* RB_createAssignmentQueue(RB_Size size, RB_Size xRange, RB_Size yRange) {
+	PixelTables* tables = createPixelTables(xRange, yRange);
+
+	if(tables == NULL) {
+		return NULL;
+	}
+
+	RB_AssignmentQueue* ret = createQueueWithPixelTables(size, xRange, yRange, tables);
+
+	if(ret == NULL) {
+		free(tables);
+	}
+
+	return ret;
+}
+
+RB_AssignmentQueue* RB_createSharedAssignmentQueue(RB_AssignmentQueue* shared, RB_Size size) {
+	return createQueueWithPixelTables(size, shared->xRange, shared->yRange, shared->pixelTables);
+}
+
+// Frees a previously allocated assignmentQueue
+void RB_freeAssignmentQueue(RB_AssignmentQueue* queue) {
+	if(queue == NULL) {
+		return;
+	}
+
+	printf("Freeing RB_AssignmentQueue!\n");
+
+	for(RB_Size bucket = 0; bucket < queue->numBuckets; bucket++) {
+		free(queue->bucketPixels[bucket]);
+	}
+
+	free(queue->bucketPixels);
+	free(queue->bucketLens);
+	free(queue->bucketCapacities);
+
+	queue->pixelTables->numQueues--;
+	if(queue->pixelTables->numQueues == 0) {
+		free(queue->pixelTables);
+	}
+
+	free(queue);
+}
+
+// Returns true if the queue is empty. Otherwise, returns false.
+bool RB_isQueueEmpty(RB_AssignmentQueue* queue) {
+	return queue->coordLen == 0;
+}
+
+bool RB_isQueueFull(RB_AssignmentQueue* queue) {
+	return queue->coordLen == queue->maxCoordLen;
+}
+
+RB_Size RB_getQueueSize(RB_AssignmentQueue* queue) {
+	return queue->coordLen;
+}
+
+RB_Size RB_getQueueCapacity(RB_AssignmentQueue* queue) {
+	return queue->maxCoordLen;
+}
+
+// Chooses the most recently queued coord from the lowest non-empty bucket and returns it.
+RB_Coord RB_chooseCoordFromAssignmentQueue(RB_AssignmentQueue* queue) {
+	if(RB_isQueueEmpty(queue)) {
+		fprintf(stderr, "AssignmentQueue is empty!!\n");
+		return (RB_Coord) { .x = -1, .y = -1 };
+	}
+
+	while(queue->bucketLens[queue->lowestBucket] == 0) {
+		queue->lowestBucket++;
+	}
+
+	RB_Size bucket = queue->lowestBucket;
+	return RB_getPixelIndexCoord(queue->bucketPixels[bucket][queue->bucketLens[bucket] - 1], queue->xRange);
+}
+
+bool RB_coordIsWithinQueueBounds(RB_AssignmentQueue* queue, RB_Coord coord) {
+	return (
+		coord.x >= 0
+		&& coord.x < queue->xRange
+		&& coord.y >= 0
+		&& coord.y < queue->yRange
+	);
+}
+
+// Returns true if the pixel's index points back at one of this queue's slots.
+bool pixelIsInQueue(RB_AssignmentQueue* queue, RB_PixelIndex pixel) {
+	int32_t index = queue->coordIndexes[pixel];
+
+	if(index == RB_QUEUE_INDEX_UNQUEUED) {
+		return false;
+	}
+
+	RB_Size bucket = queue->coordDistances[pixel];
+	return index < queue->bucketLens[bucket] && queue->bucketPixels[bucket][index] == pixel;
+}
+
+bool RB_coordIsInQueue(RB_AssignmentQueue* queue, RB_Coord coord) {
+	return (
+		RB_coordIsWithinQueueBounds(queue, coord)
+		&& pixelIsInQueue(queue, RB_getPixelIndex(coord, queue->xRange))
+	);
+}
+
+/*
+One more than the smallest distance of the coord's set neighbours. A coord with no set neighbours was queued by
+something other than a neighbouring pixel being set, so it's put in with the closest coords already queued.
+*/
+RB_Size getCoordSeedDistance(RB_AssignmentQueue* queue, RB_Coord coord) {
+	RB_Size best = RB_SEED_DISTANCE_UNKNOWN;
+
+	for(RB_Size dx = -1; dx <= 1; dx++) {
+		for(RB_Size dy = -1; dy <= 1; dy++) {
+			RB_Coord neighbor = { .x = coord.x + dx, .y = coord.y + dy };
+
+			if((dx == 0 && dy == 0) || !RB_coordIsWithinQueueBounds(queue, neighbor)) {
+				continue;
+			}
+
+			// Neighbours queued in a queue that shares the tables haven't been set either.
+			RB_PixelIndex pixel = RB_getPixelIndex(neighbor, queue->xRange);
+			if(queue->coordIndexes[pixel] != RB_QUEUE_INDEX_UNQUEUED) {
+				continue;
+			}
+
+			RB_Size distance = queue->coordDistances[pixel];
+			if(distance != RB_SEED_DISTANCE_UNKNOWN && (best == RB_SEED_DISTANCE_UNKNOWN || distance < best)) {
+				best = distance;
+			}
+		}
+	}
+
+	if(best == RB_SEED_DISTANCE_UNKNOWN) {
+		return queue->lowestBucket;
+	}
+
+	return (best + 1 < queue->numBuckets)? best + 1 : queue->numBuckets - 1;
+}
+
+// Puts the pixel in the bucket for its distance, growing the bucket if it needs to. Returns false if it couldn't grow.
+bool addPixelToBucket(RB_AssignmentQueue* queue, RB_PixelIndex pixel, RB_Size bucket) {
+	if(queue->bucketLens[bucket] == queue->bucketCapacities[bucket]) {
+		RB_Size newCapacity = (queue->bucketCapacities[bucket] == 0)?
+			RB_QUEUE_INITIAL_BUCKET_CAPACITY : queue->bucketCapacities[bucket] * 2;
+		if(newCapacity > queue->maxCoordLen) {
+			newCapacity = queue->maxCoordLen;
+		}
+
+		RB_PixelIndex* newPixels = (RB_PixelIndex*) realloc(queue->bucketPixels[bucket], sizeof(RB_PixelIndex) * newCapacity);
+
+		if(newPixels == NULL) {
+			return false;
+		}
+
+		queue->bucketPixels[bucket] = newPixels;
+		queue->bucketCapacities[bucket] = newCapacity;
+	}
+
+	queue->bucketPixels[bucket][queue->bucketLens[bucket]] = pixel;
+	queue->coordIndexes[pixel] = queue->bucketLens[bucket];
+	queue->coordDistances[pixel] = bucket;
+	queue->bucketLens[bucket]++;
+
+	if(bucket < queue->lowestBucket) {
+		queue->lowestBucket = bucket;
+	}
+
+	return true;
+}
+
+// If the coord is in the Queue, removes it. Its distance is kept for the coords queued next to it.
+void RB_removeCoordFromAssignmentQueue(RB_AssignmentQueue* queue, RB_Coord coord) {
+	if(!RB_coordIsInQueue(queue, coord)) {
+		fprintf(stderr, "Error removing coord from queue: Coord(%ld, %ld) is not in queue.\n", (long) coord.x, (long) coord.y);
+		return;
+	}
+
+	RB_PixelIndex pixel = RB_getPixelIndex(coord, queue->xRange);
+	RB_Size bucket = queue->coordDistances[pixel];
+	RB_Size coordIndex = queue->coordIndexes[pixel];
+	RB_PixelIndex lastPixel = queue->bucketPixels[bucket][queue->bucketLens[bucket] - 1];
+
+	queue->bucketPixels[bucket][coordIndex] = lastPixel;
+	queue->coordIndexes[lastPixel] = coordIndex;
+	queue->coordIndexes[pixel] = RB_QUEUE_INDEX_UNQUEUED;
+
+	queue->bucketLens[bucket]--;
+	queue->coordLen--;
+}
+
+// If the coord is not already queued or assigned, adds the coord to the queue at its distance from the seeds.
+// priorityIndex is ignored.
+void RB_addCoordToAssignmentQueue(RB_AssignmentQueue* queue, RB_Coord toAdd, RB_Size priorityIndex) {
+	(void) priorityIndex;
+
+	if(!RB_coordIsWithinQueueBounds(queue, toAdd)) {
+		fprintf(stderr, "Error adding coord to queue: Coord(%ld, %ld) is out of Bounds(%ld, %ld)!\n",
+			(long) toAdd.x, (long) toAdd.y, (long) queue->xRange, (long) queue->yRange
+		);
+		return;
+	}
+
+	if(RB_coordIsInQueue(queue, toAdd)) {
+		return;
+	}
+
+	if(RB_isQueueFull(queue)) {
+		fprintf(stderr, "Error adding coord to queue: Queue is full!\n");
+		return;
+	}
+
+	RB_Size bucket = getCoordSeedDistance(queue, toAdd);
+
+	if(!addPixelToBucket(queue, RB_getPixelIndex(toAdd, queue->xRange), bucket)) {
+		fprintf(stderr, "Error adding coord to queue: could not grow the bucket for distance %ld!\n", (long) bucket);
+		return;
+	}
+
+	queue->coordLen++;
+}
+
+bool RB_setAssignmentQueueSampling(RB_AssignmentQueue* queue, RB_QueueSampling sampling) {
+	(void) queue;
+
+	if(sampling != RB_QUEUE_SAMPLING_UNIFORM) {
+		fprintf(stderr, "Error setting queue sampling: this queue chooses coords in order, so it only supports uniform sampling!\n");
+		return false;
+	}
+
+	return true;
+}
+
+RB_QueueSampling RB_getAssignmentQueueSampling(RB_AssignmentQueue* queue) {
+	(void) queue;
+	return RB_QUEUE_SAMPLING_UNIFORM;
+}
+
+// Weights only matter to weighted sampling, so they're ignored.
+void RB_setCoordWeightInAssignmentQueue(RB_AssignmentQueue* queue, RB_Coord coord, uint32_t weight) {
+	(void) weight;
+
+	if(!RB_coordIsInQueue(queue, coord)) {
+		fprintf(stderr, "Error setting coord weight: Coord(%ld, %ld) is not in queue.\n", (long) coord.x, (long) coord.y);
+	}
+}
+
+void RB_markSeedInAssignmentQueue(RB_AssignmentQueue* queue, RB_Coord coord) {
+	if(!RB_coordIsWithinQueueBounds(queue, coord)) {
+		fprintf(stderr, "Error marking seed: Coord(%ld, %ld) is out of bounds!\n", (long) coord.x, (long) coord.y);
+		return;
+	}
+
+	if(RB_coordIsInQueue(queue, coord)) {
+		RB_removeCoordFromAssignmentQueue(queue, coord);
+	}
+
+	queue->coordDistances[RB_getPixelIndex(coord, queue->xRange)] = 0;
+}
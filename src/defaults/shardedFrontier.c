@@ -0,0 +1,303 @@
+#include "headers/RB_ShardedFrontier.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// The states a coord moves through. A coord only ever moves forward, which is what keeps it from being queued twice.
+enum {
+	RB_FRONTIER_COORD_UNQUEUED = 0,
+	RB_FRONTIER_COORD_QUEUED,
+	RB_FRONTIER_COORD_TAKEN
+};
+
+typedef struct {
+	pthread_mutex_t lock;
+
+	// Coords that were queued in this shard. A coord that has since been claimed stays here until a take runs into it
+	// and throws it away, so this can hold coords that aren't queued anymore.
+	RB_PixelIndex* coords;
+	RB_Size numCoords;
+
+	// The shard's tile is every coord with xBegin <= x < xEnd and yBegin <= y < yEnd.
+	RB_Size xBegin;
+	RB_Size xEnd;
+	RB_Size yBegin;
+	RB_Size yEnd;
+
+	// The state for rand_r. Only used while the shard is locked.
+	unsigned int randomState;
+
+	// Every other shard, nearest tile first. This is the order the shard's worker steals in.
+	int* stealOrder;
+} FrontierShard;
+
+struct RB_ShardedFrontier_s {
+	FrontierShard* shards;
+	int numShards;
+	int shardCols;
+	int shardRows;
+
+	// One RB_FRONTIER_COORD_* state for every coord, indexed by pixel index.
+	atomic_uchar* coordStates;
+	atomic_long numQueued;
+
+	RB_Size width;
+	RB_Size height;
+};
+
+atomic_uchar* getFrontierPixelState(RB_ShardedFrontier* frontier, RB_PixelIndex pixel) {
+	return frontier->coordStates + pixel;
+}
+
+bool coordIsWithinFrontierBounds(RB_ShardedFrontier* frontier, RB_Coord coord) {
+	return coord.x >= 0 && coord.x < frontier->width && coord.y >= 0 && coord.y < frontier->height;
+}
+
+// The number of tile steps between two shards, counting diagonal steps as one.
+int getShardDistance(RB_ShardedFrontier* frontier, int a, int b) {
+	int dCol = abs((a % frontier->shardCols) - (b % frontier->shardCols));
+	int dRow = abs((a / frontier->shardCols) - (b / frontier->shardCols));
+	return (dCol > dRow)? dCol : dRow;
+}
+
+/*
+Cuts the canvas into a grid of shardCols by shardRows tiles. The grid uses the factorization of numShards that is
+closest to square, with the longer side of the grid along the longer side of the canvas, so tiles stay as compact as
+possible and most of a coord's neighbours are in its own tile.
+*/
+bool buildFrontierShards(RB_ShardedFrontier* frontier) {
+	int shorter = 1;
+	for(int i = 1; i * i <= frontier->numShards; i++) {
+		if(frontier->numShards % i == 0) {
+			shorter = i;
+		}
+	}
+	int longer = frontier->numShards / shorter;
+
+	frontier->shardCols = (frontier->width >= frontier->height)? longer : shorter;
+	frontier->shardRows = (frontier->width >= frontier->height)? shorter : longer;
+
+	for(int i = 0; i < frontier->numShards; i++) {
+		FrontierShard* shard = frontier->shards + i;
+		int col = i % frontier->shardCols;
+		int row = i / frontier->shardCols;
+
+		shard->xBegin = (frontier->width * col) / frontier->shardCols;
+		shard->xEnd = (frontier->width * (col + 1)) / frontier->shardCols;
+		shard->yBegin = (frontier->height * row) / frontier->shardRows;
+		shard->yEnd = (frontier->height * (row + 1)) / frontier->shardRows;
+
+		// A coord is only ever added to its shard once, so the shard never needs more room than its tile has coords.
+		shard->coords = (RB_PixelIndex*) malloc(sizeof(RB_PixelIndex) * (shard->xEnd - shard->xBegin) * (shard->yEnd - shard->yBegin));
+		shard->stealOrder = (int*) malloc(sizeof(int) * frontier->numShards);
+
+		if((shard->coords == NULL && shard->xEnd > shard->xBegin && shard->yEnd > shard->yBegin) || shard->stealOrder == NULL) {
+			return false;
+		}
+
+		// Insertion sort the other shards by distance. Ties keep index order.
+		int numOthers = 0;
+		for(int other = 0; other < frontier->numShards; other++) {
+			if(other == i) {
+				continue;
+			}
+
+			int distance = getShardDistance(frontier, i, other);
+			int j = numOthers;
+			while(j > 0 && getShardDistance(frontier, i, shard->stealOrder[j - 1]) > distance) {
+				shard->stealOrder[j] = shard->stealOrder[j - 1];
+				j--;
+			}
+			shard->stealOrder[j] = other;
+			numOthers++;
+		}
+	}
+
+	return true;
+}
+
+RB_ShardedFrontier* RB_createShardedFrontier(RB_Size width, RB_Size height, int numShards, unsigned int seed) {
+	if(numShards < 1 || numShards > width * height) {
+		fprintf(stderr, "Error creating sharded frontier: there must be between 1 and (width * height) shards!\n");
+		return NULL;
+	}
+
+	RB_ShardedFrontier* ret = (RB_ShardedFrontier*) malloc(sizeof(RB_ShardedFrontier));
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	ret->width = width;
+	ret->height = height;
+	ret->numShards = numShards;
+	ret->coordStates = (atomic_uchar*) malloc(sizeof(atomic_uchar) * width * height);
+	ret->shards = (FrontierShard*) malloc(sizeof(FrontierShard) * numShards);
+	atomic_init(&(ret->numQueued), 0);
+
+	if(ret->coordStates == NULL || ret->shards == NULL) {
+		free(ret->coordStates);
+		free(ret->shards);
+		free(ret);
+		return NULL;
+	}
+
+	for(RB_Size i = 0; i < width * height; i++) {
+		atomic_init(ret->coordStates + i, RB_FRONTIER_COORD_UNQUEUED);
+	}
+
+	for(int i = 0; i < numShards; i++) {
+		FrontierShard* shard = ret->shards + i;
+		pthread_mutex_init(&(shard->lock), NULL);
+		shard->coords = NULL;
+		shard->numCoords = 0;
+		shard->stealOrder = NULL;
+		shard->randomState = seed + i;
+	}
+
+	if(!buildFrontierShards(ret)) {
+		fprintf(stderr, "Error creating sharded frontier: could not allocate the shards!\n");
+		RB_freeShardedFrontier(ret);
+		return NULL;
+	}
+
+	return ret;
+}
+
+void RB_freeShardedFrontier(RB_ShardedFrontier* frontier) {
+	if(frontier == NULL) {
+		return;
+	}
+
+	for(int i = 0; i < frontier->numShards; i++) {
+		pthread_mutex_destroy(&(frontier->shards[i].lock));
+		free(frontier->shards[i].coords);
+		free(frontier->shards[i].stealOrder);
+	}
+
+	free(frontier->shards);
+	free(frontier->coordStates);
+	free(frontier);
+}
+
+int RB_getNumFrontierShards(RB_ShardedFrontier* frontier) {
+	return frontier->numShards;
+}
+
+int RB_getFrontierShard(RB_ShardedFrontier* frontier, RB_Coord coord) {
+	// Invert the tile boundaries from buildFrontierShards. Rounding can land one tile off when the canvas doesn't
+	// divide evenly, so step to the right tile if it did.
+	int col = (int) ((coord.x * frontier->shardCols) / frontier->width);
+	int row = (int) ((coord.y * frontier->shardRows) / frontier->height);
+
+	while(col > 0 && coord.x < frontier->shards[col].xBegin) col--;
+	while(col < frontier->shardCols - 1 && coord.x >= frontier->shards[col].xEnd) col++;
+	while(row > 0 && coord.y < frontier->shards[row * frontier->shardCols].yBegin) row--;
+	while(row < frontier->shardRows - 1 && coord.y >= frontier->shards[row * frontier->shardCols].yEnd) row++;
+
+	return (row * frontier->shardCols) + col;
+}
+
+RB_Size RB_getFrontierSize(RB_ShardedFrontier* frontier) {
+	return atomic_load(&(frontier->numQueued));
+}
+
+bool RB_addCoordToFrontier(RB_ShardedFrontier* frontier, RB_Coord coord) {
+	if(!coordIsWithinFrontierBounds(frontier, coord)) {
+		fprintf(stderr, "Error adding coord to frontier: Coord(%ld, %ld) is out of bounds!\n", (long) coord.x, (long) coord.y);
+		return false;
+	}
+
+	RB_PixelIndex pixel = RB_getPixelIndex(coord, frontier->width);
+
+	// Only the thread that moves the coord out of the unqueued state gets to queue it.
+	unsigned char expected = RB_FRONTIER_COORD_UNQUEUED;
+	if(!atomic_compare_exchange_strong(getFrontierPixelState(frontier, pixel), &expected, RB_FRONTIER_COORD_QUEUED)) {
+		return false;
+	}
+
+	FrontierShard* shard = frontier->shards + RB_getFrontierShard(frontier, coord);
+
+	pthread_mutex_lock(&(shard->lock));
+	shard->coords[shard->numCoords] = pixel;
+	shard->numCoords++;
+	atomic_fetch_add(&(frontier->numQueued), 1);
+	pthread_mutex_unlock(&(shard->lock));
+
+	return true;
+}
+
+bool RB_claimCoordInFrontier(RB_ShardedFrontier* frontier, RB_Coord coord) {
+	if(!coordIsWithinFrontierBounds(frontier, coord)) {
+		return false;
+	}
+
+	unsigned char previous = atomic_exchange(
+		getFrontierPixelState(frontier, RB_getPixelIndex(coord, frontier->width)), RB_FRONTIER_COORD_TAKEN
+	);
+
+	if(previous == RB_FRONTIER_COORD_QUEUED) {
+		// The coord is still in its shard's array. The next take that runs into it will throw it away.
+		atomic_fetch_sub(&(frontier->numQueued), 1);
+	}
+
+	return previous != RB_FRONTIER_COORD_TAKEN;
+}
+
+// Takes a random coord from the shard, throwing away coords that were claimed since they were queued.
+bool takeCoordFromShard(RB_ShardedFrontier* frontier, FrontierShard* shard, RB_Coord* out) {
+	bool found = false;
+
+	pthread_mutex_lock(&(shard->lock));
+
+	while(!found && shard->numCoords > 0) {
+		RB_Size index = ((RB_Size) rand_r(&(shard->randomState))) % shard->numCoords;
+		RB_PixelIndex pixel = shard->coords[index];
+
+		shard->numCoords--;
+		shard->coords[index] = shard->coords[shard->numCoords];
+
+		unsigned char expected = RB_FRONTIER_COORD_QUEUED;
+		if(atomic_compare_exchange_strong(getFrontierPixelState(frontier, pixel), &expected, RB_FRONTIER_COORD_TAKEN)) {
+			atomic_fetch_sub(&(frontier->numQueued), 1);
+			*out = RB_getPixelIndexCoord(pixel, frontier->width);
+			found = true;
+		}
+	}
+
+	pthread_mutex_unlock(&(shard->lock));
+
+	return found;
+}
+
+bool RB_takeCoordFromFrontier(RB_ShardedFrontier* frontier, int shardIndex, RB_Coord* out) {
+	if(shardIndex < 0 || shardIndex >= frontier->numShards) {
+		fprintf(stderr, "Error taking coord from frontier: %d is not a valid shard!\n", shardIndex);
+		return false;
+	}
+
+	FrontierShard* home = frontier->shards + shardIndex;
+
+	if(takeCoordFromShard(frontier, home, out)) {
+		return true;
+	}
+
+	// Steal from the nearest shard that has anything. Stop early once nothing is queued anywhere. That can miss a
+	// coord that's being added right now, but the caller has to handle that anyway, because other threads can always
+	// add coords after this returns.
+	for(int i = 0; i < frontier->numShards - 1; i++) {
+		FrontierShard* victim = frontier->shards + home->stealOrder[i];
+
+		if(atomic_load(&(frontier->numQueued)) == 0) {
+			return false;
+		}
+
+		if(takeCoordFromShard(frontier, victim, out)) {
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -4,9 +4,25 @@
 #include "RB_Main.h"
 #include "RB_BasicTypes.h"
 
+// The number of distinct priorities. Coords with the best priority are always chosen first.
+#define RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES 64
+
+// The weight a coord has when it's first queued.
+#define RB_ASSIGNMENT_QUEUE_DEFAULT_WEIGHT 1
+
 // Allocates an assignmentQueue capable of storing the specified number of coords.
 RB_AssignmentQueue* RB_createAssignmentQueue(RB_Size, RB_Size, RB_Size);
 
+/*
+Allocates an assignmentQueue capable of storing the specified number of coords, on the same canvas as the other queue.
+A queue's tables indexed by pixel cost several bytes for every pixel of the canvas, queued or not, so this queue shares
+the other queue's instead, and only costs as much as the coords it holds.
+A coord must never be in two queues that share tables at once. Each queue only writes the entries of its own coords,
+and only trusts an entry that points back at one of its own slots. The tables are freed with the last queue using
+them, so the queues can be freed in any order.
+*/
+RB_AssignmentQueue* RB_createSharedAssignmentQueue(RB_AssignmentQueue* shared, RB_Size);
+
 // Frees a previously allocated assignmentQueue
 void RB_freeAssignmentQueue(RB_AssignmentQueue*);
 
@@ -20,7 +36,9 @@ RB_Size RB_getQueueSize(RB_AssignmentQueue*);
 
 RB_Size RB_getQueueCapacity(RB_AssignmentQueue*);
 
-// Chooses (using an implementation-specific method) a coord from the queue and returns it.
+// Chooses a coord from the queue and returns it. The coord is chosen at random from the coords with the best
+// priority: uniformly, in proportion to their weights with RB_QUEUE_SAMPLING_WEIGHTED, or mostly close to the
+// previous choice with RB_QUEUE_SAMPLING_TILED.
 RB_Coord RB_chooseCoordFromAssignmentQueue(RB_AssignmentQueue*);
 
 bool RB_coordIsWithinQueueBounds(RB_AssignmentQueue*, RB_Coord);
@@ -31,15 +49,29 @@ bool RB_coordIsInQueue(RB_AssignmentQueue*, RB_Coord);
 void RB_removeCoordFromAssignmentQueue(RB_AssignmentQueue*, RB_Coord);
 
 /*
-- If the coord is not already queued or assigned, adds the coord to the queue (with the specified priority, if
-the RB_AssignmentQueue implementation supports prioritization).
-- If the coord is already queued and the RB_AssignmentQueue implementation supports prioritization,this function may update
-the coord's priority, though that is not guaranteed.
+- If the coord is not already queued or assigned, adds the coord to the queue with the specified priority.
+- If the coord is already queued, moves it to the specified priority.
 
 Higher positive values for priorityIndex correspond to lower prioritization. A priorityIndex of 0 corresponds to the maximum
 possible prioritization.
-Negative values for priorityIndex correspond to the lowest possible prioritization.
+Negative values for priorityIndex, and values of RB_ASSIGNMENT_QUEUE_NUM_PRIORITIES or more, correspond to the lowest
+possible prioritization.
 */
 void RB_addCoordToAssignmentQueue(RB_AssignmentQueue*, RB_Coord, RB_Size priorityIndex);
 
+// Switches how RB_chooseCoordFromAssignmentQueue picks among the coords with the best priority. Weighted sampling
+// costs O(log n) per add, remove and weight change, instead of O(1). Returns false if the switch failed, in which
+// case the queue keeps its old mode.
+bool RB_setAssignmentQueueSampling(RB_AssignmentQueue*, RB_QueueSampling);
+
+RB_QueueSampling RB_getAssignmentQueueSampling(RB_AssignmentQueue*);
+
+// Sets the weight of a queued coord, which must be at least 1. A coord keeps its weight when its priority changes,
+// and goes back to RB_ASSIGNMENT_QUEUE_DEFAULT_WEIGHT once it's removed.
+void RB_setCoordWeightInAssignmentQueue(RB_AssignmentQueue*, RB_Coord, uint32_t weight);
+
+// Tells the queue that the coord was set without being chosen from it, like a seed pixel. Queues that order coords by
+// their distance from the seeds measure it from these coords. Other queues ignore this.
+void RB_markSeedInAssignmentQueue(RB_AssignmentQueue*, RB_Coord);
+
 #endif
\ No newline at end of file
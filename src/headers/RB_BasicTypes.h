@@ -11,6 +11,11 @@
 
 #define RB_MAXIMUM_COLOR_CHANNEL_RESOLUTION 0x100
 
+// Value representing the maximum number of pixels that this program can handle.
+// When every color is used exactly once, this is the same as the number of colors. Using each color more than once
+// allows larger images, up to this limit.
+#define RB_MAXIMUM_POSSIBLE_NUMBER_OF_PIXELS 0x40000000
+
 typedef uint_fast8_t RB_ColorChannel; 
 
 // Type big enough to represent the bounds of a color channel.
@@ -33,6 +38,11 @@ typedef int_fast16_t RB_ColorChannelDifference;
 typedef uint_fast32_t RB_ColorSquareDistance;
 
 
+// The number of times a single color may be used in an image.
+// Guaranteed to be an unsigned integral type with at least 32 bits.
+typedef uint_least32_t RB_ColorCount;
+
+
 typedef struct {
 	RB_ColorChannel r;
 	RB_ColorChannel g;
@@ -63,6 +73,20 @@ typedef struct {
 	RB_Size y;
 } RB_Coord;
 
+// A coord packed into a single integer, (y * width) + x, for a map of known width. A quarter of the size of an
+// RB_Coord, which matters in the arrays that hold one per queued coord or one per pixel. Big enough for
+// RB_MAXIMUM_POSSIBLE_NUMBER_OF_PIXELS pixels.
+typedef uint32_t RB_PixelIndex;
+
+// The coord must be inside a map of the specified width.
+static inline RB_PixelIndex RB_getPixelIndex(RB_Coord coord, RB_Size width) {
+	return (RB_PixelIndex) ((coord.y * width) + coord.x);
+}
+
+static inline RB_Coord RB_getPixelIndexCoord(RB_PixelIndex index, RB_Size width) {
+	return (RB_Coord) { .x = (RB_Size) (index % width), .y = (RB_Size) (index / width) };
+}
+
 
 // Functions!
 
@@ -73,4 +97,7 @@ bool RB_colorsAreEqual(RB_Color, RB_Color);
 // Returns true if the two coords are equal. Otherwise returns false.
 bool RB_coordsAreEqual(RB_Coord, RB_Coord);
 
+// Returns the square of the euclidean distance between the two colors.
+RB_ColorSquareDistance RB_getColorSquareDistance(RB_Color, RB_Color);
+
 #endif
\ No newline at end of file
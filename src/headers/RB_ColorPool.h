@@ -4,20 +4,138 @@
 #include "RB_Main.h"
 #include "RB_BasicTypes.h"
 #include <stdbool.h>
+#include <stdio.h>
+
+// The algorithms RB_findIdealAvailableColor can use to search the pool.
+typedef enum {
+	// Walks the octant tree from the root, discarding octants whose bounds can't beat the best worst case.
+	RB_COLOR_POOL_ENGINE_OCTANT_TREE,
+	// Visits fixed-size cells of the color cube in order of increasing distance from the desired color's cell,
+	// using precomputed lists of the cells on each "shell" of the sphere around it. See notes.md.
+	RB_COLOR_POOL_ENGINE_OCTANT_SPHERE
+} RB_ColorPoolSearchEngine;
+
+// The formats RB_createColorPoolFromFile can read.
+typedef enum {
+	// A binary (P6) PPM with one byte per channel. Every pixel becomes a color, and anything after the last pixel is
+	// ignored.
+	RB_COLOR_FILE_PPM,
+	// Nothing but colors, three bytes each in r, g, b order. The file's size must be a multiple of 3.
+	RB_COLOR_FILE_RAW_RGB
+} RB_ColorFileFormat;
 
 // Allocates a colorPool with the specified range of colors.
 RB_ColorPool* RB_createColorPool(RB_ColorChannelSize, RB_ColorChannelSize, RB_ColorChannelSize);
 
+// Allocates a colorPool with the specified range of colors, where each color can be used `multiplicity` times before
+// it is removed. The pool takes the same amount of memory regardless of multiplicity.
+RB_ColorPool* RB_createColorPoolWithMultiplicity(
+	RB_ColorChannelSize,
+	RB_ColorChannelSize,
+	RB_ColorChannelSize,
+	RB_ColorCount multiplicity
+);
+
+// Allocates a colorPool containing exactly the specified colors. A color that appears more than once can be used once
+// per appearance. Only the colors that appear are stored, so the palette can be any set of colors.
+RB_ColorPool* RB_createColorPoolFromColors(const RB_Color* colors, RB_Size numColors);
+
+// Allocates a colorPool holding counts[((r * gSize) + g) * bSize + b] uses of every color with rBegin <= r < rEnd,
+// g < gSize and b < bSize, so a slab of a larger cube can be built straight from that cube's counts. Like
+// RB_createColorPoolFromColors, colors with a count of 0 are left out. Returns NULL if none are left.
+RB_ColorPool* RB_createColorPoolFromCounts(
+	const RB_ColorCount* counts,
+	RB_ColorChannelSize rBegin,
+	RB_ColorChannelSize rEnd,
+	RB_ColorChannelSize gSize,
+	RB_ColorChannelSize bSize
+);
+
+// Like RB_createColorPoolFromColors, but reads the colors from a file in the specified format, which is memory-mapped
+// rather than read into memory. Returns NULL if the file can't be read or isn't in that format.
+RB_ColorPool* RB_createColorPoolFromFile(const char* path, RB_ColorFileFormat format);
+
+// Allocates an exact copy of the pool, including its search engine and everything already removed from it.
+// Much cheaper than building a new pool, so runs that need a fresh pool each time should clone one pristine pool.
+RB_ColorPool* RB_cloneColorPool(const RB_ColorPool*);
+
 // Frees a previously allocated color pool
 void RB_freeColorPool(RB_ColorPool*);
 
+// Selects the search engine used by RB_findIdealAvailableColor. The default is RB_COLOR_POOL_ENGINE_OCTANT_TREE.
+// Both engines return a color at the minimum possible distance, so switching engines only affects speed.
+// Returns false (and keeps the current engine) if the engine's data could not be allocated.
+bool RB_setColorPoolSearchEngine(RB_ColorPool*, RB_ColorPoolSearchEngine);
+
 RB_Color RB_findIdealAvailableColor(RB_ColorPool*, RB_Color);
 
+// Finds the k available colors closest to the desired color without removing anything from the pool.
+// out and outDist must each have room for k values. They are filled in order of increasing square distance.
+// Returns the number of colors found, which is less than k only if the pool contains fewer than k colors.
+RB_Size RB_findKNearestAvailableColors(RB_ColorPool*, RB_Color desired, RB_Size k, RB_Color* out, RB_ColorSquareDistance* outDist);
+
+// Finds the available color closest to the desired color out of those whose channels all lie between the channels of
+// boxMin and boxMax, inclusive, and stores it in out.
+// Returns false (and leaves out unchanged) if the box doesn't contain any available colors.
+bool RB_findIdealAvailableColorInBox(RB_ColorPool*, RB_Color desired, RB_Color boxMin, RB_Color boxMax, RB_Color* out);
+
+// Chooses an available color at random, weighted by its number of remaining uses, from those whose square distance from the desired color is between
+// minSquareDist and maxSquareDist, inclusive, and stores it in out. Useful for picking colors that are "slightly
+// different" from the desired color instead of as close as possible.
+// Returns false (and leaves out unchanged) if no available color is within that band.
+bool RB_findRandomAvailableColorInBand(
+	RB_ColorPool*,
+	RB_Color desired,
+	RB_ColorSquareDistance minSquareDist,
+	RB_ColorSquareDistance maxSquareDist,
+	RB_Color* out
+);
+
+// Finds an available color at the maximum possible distance from the specified color.
+RB_Color RB_findFarthestAvailableColor(RB_ColorPool*, RB_Color from);
+
+// Finds the available color whose distance to the closest color in the set is as large as possible, and stores it in
+// out. Picking each seed color as the farthest from the ones already picked spreads the seeds across the palette.
+// Returns false (and leaves out unchanged) if the pool is empty or the set has no colors.
+bool RB_findFarthestAvailableColorFromSet(RB_ColorPool*, const RB_Color* set, RB_Size setSize, RB_Color* out);
+
+// Chooses an available color uniformly at random, where a color with several remaining uses counts once per use.
+// Takes O(depth) time, however few colors are left, so it's the cheap way to pick seed colors late in a run.
+RB_Color RB_sampleRandomAvailableColor(RB_ColorPool*);
+
 bool RB_colorIsAvailableInPool(RB_ColorPool*, RB_Color);
 
-// Attempts to remove the specified color from the pool.
-// If the specified color is contained by the Color Pool, removes it and returns true.
-// If the specified color is not contained by the Color Pool, returns false.
+// Attempts to remove one use of the specified color from the pool.
+// If the specified color is contained by the Color Pool, removes one use of it and returns true. The color stays
+// available until all of its uses have been removed.
+// If the specified color is not contained by the Color Pool, returns false. While the pool is journaling, also returns
+// false without changing anything if the journal can't be grown to record the removal.
 bool RB_removeColorFromPool(RB_ColorPool*, RB_Color);
 
+
+// Writes the shape of the pool's octant tree to the stream as JSON, for the OctantTreeGeneration visualizer: per-level
+// octant and leaf block counts, child-count histograms, available colors, and how often tree searches expanded each
+// level, which are only counted after RB_setColorPoolExpansionCounting. Octants on levels no deeper than
+// maxDetailedDepth are also listed individually (-1 lists none). Returns false if the export failed.
+bool RB_exportColorPoolTree(RB_ColorPool*, FILE*, int maxDetailedDepth);
+
+// Makes tree searches count how often they expand each octant, for RB_exportColorPoolTree. Off by default, since
+// counting writes to every octant a search looks through. Clones start with the same setting.
+void RB_setColorPoolExpansionCounting(RB_ColorPool*, bool);
+
+// SPECULATIVE REMOVAL
+// A position in the pool's undo journal.
+typedef RB_Size RB_PoolMark;
+
+// Starts recording every change RB_removeColorFromPool makes to the pool (if it isn't already) and returns a mark that
+// RB_poolRollback can return to. Marks can be nested.
+RB_PoolMark RB_poolMark(RB_ColorPool*);
+
+// Undoes every removal made since the mark was taken. Takes time proportional to the number of changes being undone,
+// not the size of the pool. Marks taken after this one become invalid; this mark and earlier ones stay valid.
+void RB_poolRollback(RB_ColorPool*, RB_PoolMark);
+
+// Keeps every removal made so far, invalidates all marks, and stops recording changes.
+void RB_poolCommit(RB_ColorPool*);
+
 #endif
\ No newline at end of file
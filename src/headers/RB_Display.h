@@ -13,6 +13,7 @@ Parameters:
 		The width and height of the pixelMap that the display will be showing.
 	rRes, gRes, bRes:
 		The resolutions of each of the color channels
+Headless runs have no display, so the functions that take one also accept NULL, and do nothing with it.
 */
 RB_Display* RB_createDisplay(
 	int wWidth, int wHeight,
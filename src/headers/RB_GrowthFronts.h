@@ -0,0 +1,51 @@
+#ifndef EKW_RAINBOW_RB_GROWTH_FRONTS_H
+#define EKW_RAINBOW_RB_GROWTH_FRONTS_H
+
+#include "RB_Main.h"
+#include "RB_BasicTypes.h"
+#include <stdbool.h>
+
+/*
+Several fronts growing at once, each with its own assignment queue. Every coord belongs to the front that queued or
+set it. When a front touches a coord that belongs to another front, the two have collided and get merged into one
+front that holds both of their queued coords.
+Merges are union-find: the front with the smaller queue is drained into the other's queue and then points at it. The
+coords' fronts are never rewritten, only looked up through the fronts they point at, so a merge only costs as much as
+the smaller queue.
+Each front's state is kept on its own cache lines, and a front only ever touches the coords it owns, so fronts could
+later be grown on separate threads.
+The fronts' queues share their per-pixel tables, with RB_createSharedAssignmentQueue.
+*/
+typedef struct RB_GrowthFronts_s RB_GrowthFronts;
+
+// Allocates a queue for each of the fronts, on a canvas of the specified size, using the specified sampling.
+RB_GrowthFronts* RB_createGrowthFronts(
+	RB_Size width, RB_Size height,
+	const RB_GrowthFront* fronts, int numFronts,
+	RB_FrontScheduling scheduling, RB_QueueSampling sampling
+);
+
+void RB_freeGrowthFronts(RB_GrowthFronts*);
+
+// Returns the front that the front has been merged into, or the front itself if it hasn't been.
+int RB_findGrowthFront(RB_GrowthFronts*, int front);
+
+// The queue of the front that the front has been merged into.
+RB_AssignmentQueue* RB_getGrowthFrontQueue(RB_GrowthFronts*, int front);
+
+// Returns the front the coord belongs to, after merges, or -1 if no front has queued or set it. Coords can be queued
+// without a front, like released reserved pixels, so a coord that doesn't belong to a front may still be queued.
+int RB_getCoordGrowthFront(RB_GrowthFronts*, RB_Coord);
+
+void RB_setCoordGrowthFront(RB_GrowthFronts*, RB_Coord, int front);
+
+// Merges the two fronts, and returns the one that's left. The other front's queued coords are moved into its queue.
+int RB_mergeGrowthFronts(RB_GrowthFronts*, RB_PixelMap*, int a, int b);
+
+// Returns the front whose turn it is to set a pixel, skipping fronts with empty queues, or -1 if every queue is empty.
+int RB_chooseGrowthFront(RB_GrowthFronts*);
+
+// Returns true if every front's queue is empty.
+bool RB_growthFrontsAreEmpty(RB_GrowthFronts*);
+
+#endif
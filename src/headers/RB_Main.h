@@ -11,11 +11,54 @@ typedef struct RB_AssignmentQueue_s RB_AssignmentQueue;
 typedef struct RB_ColorPool_s RB_ColorPool;
 typedef struct RB_PixelMap_s RB_PixelMap;
 typedef struct RB_Display_s RB_Display;
+typedef struct RB_MatchSchedule_s RB_MatchSchedule;
+typedef struct RB_GrowthFronts_s RB_GrowthFronts;
 
 typedef struct RB_Data_s RB_Data;
 
 typedef struct RB_Config_s RB_Config;
 
+#define RB_MAXIMUM_PALETTE_REGIONS 16
+
+// A rectangle of the pixel map whose pixels may only use colors from a box of the color cube.
+typedef struct {
+	// Both corners are inclusive.
+	RB_Coord mapMin;
+	RB_Coord mapMax;
+	RB_Color colorMin;
+	RB_Color colorMax;
+} RB_PaletteRegion;
+
+#define RB_MAXIMUM_GROWTH_FRONTS 16
+
+// A front of pixels that grows outwards from its own seeds, with its own queue.
+typedef struct {
+	// Not owned by the config.
+	const char* name;
+	// How many pixels the front gets for every one the others get, with RB_FRONT_SCHEDULING_WEIGHTED.
+	uint32_t weight;
+} RB_GrowthFront;
+
+// How RB_generateNextPixel takes turns between the growth fronts.
+typedef enum {
+	// Every front that still has queued coords gets one pixel in turn.
+	RB_FRONT_SCHEDULING_ROUND_ROBIN,
+	// Fronts get pixels in proportion to their weights, interleaved as evenly as possible.
+	RB_FRONT_SCHEDULING_WEIGHTED
+} RB_FrontScheduling;
+
+// How the assignment queue chooses among the coords with the best priority.
+typedef enum {
+	// Every coord is equally likely.
+	RB_QUEUE_SAMPLING_UNIFORM,
+	// Coords are chosen in proportion to their weights. The pixel map weighs a coord by how many of its neighbours
+	// are already set, so gaps get filled before they turn into isolated holes.
+	RB_QUEUE_SAMPLING_WEIGHTED,
+	// Like uniform, but most choices are made close to the previous one, so the pixels being read and written are
+	// still in cache. Faster on large canvases.
+	RB_QUEUE_SAMPLING_TILED
+} RB_QueueSampling;
+
 // TODO: Decouple display from the rest of rainbow so that these structs don't need to be visible.
 struct RB_Config_s {
 	RB_Size width;
@@ -27,19 +70,63 @@ struct RB_Config_s {
 	RB_ColorChannelSize bRes;
 	bool colorResSet;
 
+	// The number of times each color is used. Defaults to 1.
+	RB_ColorCount colorMultiplicity;
+
 	int windowWidth;
 	int windowHeight;
 	bool windowDimensionsSet;
 
 	uint32_t seed;
 	bool seedSet;
+
+	// If a pixel is in more than one region, the region added first is used.
+	RB_PaletteRegion paletteRegions[RB_MAXIMUM_PALETTE_REGIONS];
+	int numPaletteRegions;
+
+	// If not NULL, RB_init clones this pool instead of building a new one. Not owned by the config.
+	RB_ColorPool* colorPoolTemplate;
+	// If true, RB_init uses the template itself instead of a clone, and the RB_Data takes ownership of it. Only for a
+	// process that has its own copy-on-write copy of the template, like a forked job. Defaults to false.
+	bool takeColorPoolTemplate;
+
+	// If not NULL, the color pool's tree is exported every colorPoolExportInterval generated pixels. Not owned by
+	// the config.
+	const char* colorPoolExportPrefix;
+	RB_Size colorPoolExportInterval;
+	int colorPoolExportDetailDepth;
+
+	// Defaults to RB_QUEUE_SAMPLING_UNIFORM.
+	RB_QueueSampling queueSampling;
+
+	// The fraction of pixels held back until everything else has been generated. Defaults to 0.
+	double reservedPixelFraction;
+
+	// Defaults to false.
+	bool bestMatchScheduling;
+
+	// If there are none, every pixel is generated from one shared queue.
+	RB_GrowthFront growthFronts[RB_MAXIMUM_GROWTH_FRONTS];
+	int numGrowthFronts;
+	// Defaults to RB_FRONT_SCHEDULING_ROUND_ROBIN.
+	RB_FrontScheduling frontScheduling;
+
+	// If true, no display is created, and RB_Data's display is NULL. Defaults to false.
+	bool headless;
 };
 
 struct RB_Data_s {
 	RB_AssignmentQueue* assignmentQueue; // the queue of coordinates that should be assigned a color.
+	// NULL unless the config has growth fronts, in which case each front has its own queue and assignmentQueue is NULL.
+	RB_GrowthFronts* growthFronts;
 	RB_ColorPool* colorPool;
 	RB_PixelMap* pixelMap;
 	RB_Display* display;
+	// NULL unless best-match scheduling is on.
+	RB_MatchSchedule* matchSchedule;
+
+	// The number of pixels RB_generateNextPixel has colored.
+	RB_Size numPixelsGenerated;
 
 	RB_Config config;
 };
@@ -52,25 +139,93 @@ void RB_setColorResolution(RB_Config*, RB_ColorChannelSize, RB_ColorChannelSize,
 
 void RB_setMapDimensions(RB_Config*, RB_Size, RB_Size);
 
+// Uses every color the specified number of times, so width * height must equal rRes * gRes * bRes * multiplicity.
+// If both the color resolution and the map dimensions are going to be set, set the multiplicity first.
+void RB_setColorMultiplicity(RB_Config*, RB_ColorCount);
+
 void RB_setWindowDimensions(RB_Config*, int, int);
 
 void RB_setRandomSeed(RB_Config*, uint32_t);
 
+// Restricts the pixels between mapMin and mapMax (inclusive) to colors between colorMin and colorMax (inclusive).
+// Once a region's colors run out, its pixels fall back to using any available color.
+void RB_addPaletteRegion(RB_Config*, RB_Coord mapMin, RB_Coord mapMax, RB_Color colorMin, RB_Color colorMax);
+
+// Makes RB_init clone the pool instead of building one from scratch, which is much faster when many images are
+// generated with the same colors. The pool must hold exactly the colors the config describes, must not be removed
+// from, and must outlive every RB_init call that uses it. Pass NULL to go back to building a new pool each time.
+void RB_setColorPoolTemplate(RB_Config*, RB_ColorPool*);
+
+// Exports the color pool's tree (see RB_exportColorPoolTree) to "<pathPrefix><pixels generated>.json" every
+// `interval` generated pixels, and once more when generation finishes. Pass NULL to stop exporting. Exporting turns on
+// the pool's expansion counting, which makes searches a little slower.
+void RB_setColorPoolExport(RB_Config*, const char* pathPrefix, RB_Size interval, int maxDetailedDepth);
+
+// Sets how the next pixel to generate is chosen from the frontier. See RB_QueueSampling.
+void RB_setQueueSampling(RB_Config*, RB_QueueSampling);
+
+// Holds back about the specified fraction of the pixels, spread evenly over the map, until every other pixel has been
+// generated. The pixels that are hardest to match end up scattered instead of clumped where the fill finishes.
+// The fraction must be between 0 and 0.5.
+void RB_setReservedPixelFraction(RB_Config*, double fraction);
+
+// Instead of choosing the next pixel at random, chooses the queued pixel whose preferred color has the closest
+// available match, which keeps late pixels from being stuck with far-off colors. The queue's priorities and sampling
+// are ignored, except for pixels the schedule hasn't seen yet, like released reserved pixels, which are chosen from
+// the queue whenever the schedule runs dry. Defaults to false.
+void RB_setBestMatchScheduling(RB_Config*, bool);
+
+// Adds a front with its own queue, and returns its index, or -1 if there are already RB_MAXIMUM_GROWTH_FRONTS.
+// Seed a front with RB_setCoordColorInFront. Pixels set with RB_setCoordColor go to front 0. When two fronts touch,
+// they're merged into one front with both of their weights.
+int RB_addGrowthFront(RB_Config*, const char* name, uint32_t weight);
+
+// Sets how the growth fronts take turns. See RB_FrontScheduling. With best-match scheduling on, pixels are chosen
+// across all fronts by how well they match instead, so one front can end up with most of the image.
+void RB_setFrontScheduling(RB_Config*, RB_FrontScheduling);
+
+// Skips creating the display, so rainbow can run on machines without one. Defaults to false.
+void RB_setHeadless(RB_Config*, bool);
+
 
 // ALLOCATION FUNCTIONS:
 RB_Data* RB_init(RB_Config*);
 
 void RB_free(RB_Data*);
 
+// A job run by RB_runForkedJobs. Returns false if the job failed.
+typedef bool (*RB_JobFunction)(RB_Data*, int jobIndex, void* userData);
+
+// Runs numJobs jobs, each in its own forked process, with at most numWorkers of them running at once. If the config has
+// no color pool template, one is built before forking. Every job inherits the template copy-on-write and uses it in
+// place, so a job only pays for the pages of the pool it writes to. Jobs are always headless.
+// Job i is initialized from the config with its seed set to (the config's seed, or the time if unset) + i.
+// Returns the number of jobs that failed, or -1 if the workers could not be started.
+int RB_runForkedJobs(RB_Config*, int numJobs, int numWorkers, RB_JobFunction, void* userData);
+
 
 // HELPER FUNCTIONS
+// Returns a random color within the color resolution. The color may already have been used.
 RB_Color RB_getRandomColor(RB_Data*);
 
+// Returns a random color that is still available, chosen uniformly from the remaining uses.
+RB_Color RB_getRandomAvailableColor(RB_Data*);
+
 RB_Coord RB_getRandomCoord(RB_Data*);
 
+// Finds the ideal available color for the coord, respecting any palette region the coord is in.
+RB_Color RB_findIdealAvailableColorForCoord(RB_Data*, RB_Coord, RB_Color preferredColor);
+
 // GENERATION FUNCTIONS:
 void RB_setCoordColor(RB_Data*, RB_Coord, RB_Color);
 
+// RB_setCoordColor, but the pixel seeds the specified growth front, or whatever front it has been merged into.
+void RB_setCoordColorInFront(RB_Data*, int front, RB_Coord, RB_Color);
+
+// Sets every coords[i] to colors[i], like calling RB_setCoordColor for each, but queues the resulting coords in one
+// pass at the end. Much faster for seeding many pixels at once.
+void RB_setCoordColors(RB_Data*, const RB_Coord* coords, const RB_Color* colors, RB_Size numCoords);
+
 // Sets the color for another pixel. Returns true if there are pixels left to generate, otherwise returns false.
 bool RB_generateNextPixel(RB_Data*);
 
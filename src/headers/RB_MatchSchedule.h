@@ -0,0 +1,52 @@
+#ifndef EKW_RAINBOW_RB_MATCH_SCHEDULE_H
+#define EKW_RAINBOW_RB_MATCH_SCHEDULE_H
+
+#include "RB_Main.h"
+#include "RB_BasicTypes.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+A min-heap of frontier coords, each keyed by how well it can currently be matched to an available color. What the
+key means is up to the caller. Popping the heap gives the coord with the smallest key.
+Matches are cached, and a cached match is never updated in place. Rescheduling or unscheduling a coord just gives it
+a new version, and entries with an old version are thrown away when they reach the top of the heap. Whoever pops an
+entry is responsible for checking that its color is still available.
+*/
+typedef struct RB_MatchSchedule_s RB_MatchSchedule;
+
+typedef struct {
+	RB_Coord coord;
+	// Only meaningful if hasColor is true. Otherwise the coord hasn't been matched since it was last rescheduled, and
+	// the key is only an estimate.
+	RB_Color color;
+	uint32_t key;
+	bool hasColor;
+} RB_ScheduledMatch;
+
+// Allocates an empty schedule for a canvas of the specified size.
+RB_MatchSchedule* RB_createMatchSchedule(RB_Size width, RB_Size height);
+
+void RB_freeMatchSchedule(RB_MatchSchedule*);
+
+// Schedules the coord with a cached match, replacing whatever it was scheduled with before.
+void RB_scheduleMatch(RB_MatchSchedule*, RB_Coord, RB_Color color, uint32_t key);
+
+// Schedules the coord without a match, replacing whatever it was scheduled with before. Use this when the coord's
+// preferred color may have changed, with the best estimate of its new key.
+void RB_scheduleUnmatchedCoord(RB_MatchSchedule*, RB_Coord, uint32_t estimate);
+
+// Drops the coord from the schedule, if it's in it.
+void RB_unscheduleCoord(RB_MatchSchedule*, RB_Coord);
+
+// Gets the color the coord was last scheduled with by RB_scheduleMatch. Returns false if it never was. The color may
+// have been taken since.
+bool RB_getLastScheduledColor(RB_MatchSchedule*, RB_Coord, RB_Color* out);
+
+// Removes the coord with the smallest key from the schedule. Returns false if the schedule is empty.
+bool RB_popScheduledMatch(RB_MatchSchedule*, RB_ScheduledMatch* out);
+
+// The smallest key in the schedule, or UINT32_MAX if the schedule is empty.
+uint32_t RB_peekScheduledKey(RB_MatchSchedule*);
+
+#endif
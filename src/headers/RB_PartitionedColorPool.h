@@ -0,0 +1,48 @@
+#ifndef EKW_RAINBOW_RB_PARTITIONED_COLOR_POOL_H
+#define EKW_RAINBOW_RB_PARTITIONED_COLOR_POOL_H
+
+#include "RB_Main.h"
+#include "RB_BasicTypes.h"
+#include <stdbool.h>
+
+/*
+A color pool split into partitions that can be searched by several threads at once. Each partition owns a slab of the
+color cube (a range of red values) and has its own RB_ColorPool and its own lock, so threads whose desired colors fall
+in different partitions never wait on each other. A query only looks at other partitions when they could hold a
+closer color than the best one in the desired color's own partition.
+As colors are used up, the slabs are moved so that every partition keeps roughly the same number of available colors.
+The generator doesn't use it yet. It's only the thread-safe pool that growing an image on several threads would need,
+and it has only been checked for exactness, not for how well it scales with the number of threads.
+*/
+typedef struct RB_PartitionedColorPool_s RB_PartitionedColorPool;
+
+// Allocates a partitioned pool of the specified range of colors, each of which can be used `multiplicity` times,
+// split into numPartitions partitions. There can't be more partitions than red values.
+RB_PartitionedColorPool* RB_createPartitionedColorPool(
+	RB_ColorChannelSize rSize,
+	RB_ColorChannelSize gSize,
+	RB_ColorChannelSize bSize,
+	RB_ColorCount multiplicity,
+	int numPartitions
+);
+
+// Frees a previously allocated partitioned pool. No other thread may be using it.
+void RB_freePartitionedColorPool(RB_PartitionedColorPool*);
+
+int RB_getNumColorPoolPartitions(RB_PartitionedColorPool*);
+
+// Returns the partition whose slab currently contains the color. Threads that mostly take colors from one partition
+// don't contend with each other, so this is the partition a worker thread should be given work for.
+// The answer can change whenever the partitions are rebalanced.
+int RB_getColorPoolPartition(RB_PartitionedColorPool*, RB_Color);
+
+// Finds an available color at the minimum possible distance from the desired color, removes one use of it from the
+// pool, and stores it in out. Safe to call from any number of threads at once.
+// Returns false if the pool has no colors left, or if the color that was found couldn't be removed.
+bool RB_takeIdealAvailableColor(RB_PartitionedColorPool*, RB_Color desired, RB_Color* out);
+
+// Removes one use of a specific color. Safe to call from any number of threads at once.
+// Returns false if the color isn't available.
+bool RB_takeColorFromPartitionedPool(RB_PartitionedColorPool*, RB_Color);
+
+#endif
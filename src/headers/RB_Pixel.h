@@ -9,12 +9,13 @@ typedef enum {
 	RB_PIXEL_SET
 } RB_PixelStatus;
 
+// A pixel doesn't store its own coord. The pixel map can work it out from where the pixel is, and leaving it out makes a
+// pixel 4 bytes instead of 24.
 typedef struct {
-	RB_Coord loc;
-
 	RB_Color color;
-	
-	RB_PixelStatus status;
+
+	// An RB_PixelStatus.
+	uint8_t status;
 } RB_Pixel;
 
 #endif
\ No newline at end of file
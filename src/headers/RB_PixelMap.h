@@ -17,7 +17,29 @@ RB_Pixel* RB_getPixel(RB_PixelMap*, RB_Coord);
 // Determines, based on the current state of the pixelMap, the preferred color for the specified coordinate.
 RB_Color RB_determinePreferredCoordColor(RB_PixelMap*, RB_Coord);
 
-// Add cords to the queue in an implementation-defined pattern relative to the given coord
+// The number of set pixels in the 3x3 block centered on the coord, counting the coord itself.
+int RB_countSetPixelsAround(RB_PixelMap*, RB_Coord);
+
+// Add cords to the queue in an implementation-defined pattern relative to the given coord, which has just been set.
 void RB_addResultantCoordsToQueue(RB_PixelMap*, RB_AssignmentQueue*, RB_Coord);
 
+// Does the same as calling RB_addResultantCoordsToQueue for each of the coords, which have all just been set, but
+// faster.
+void RB_addResultantCoordsOfBatchToQueue(RB_PixelMap*, RB_AssignmentQueue*, const RB_Coord*, RB_Size);
+
+// Moves every coord queued in the first queue into the second, with the same weights in a weighted queue. The coords
+// stay queued as far as the map is concerned.
+void RB_moveQueuedCoords(RB_PixelMap*, RB_AssignmentQueue* from, RB_AssignmentQueue* to);
+
+// Reserves about the specified fraction of the pixels, spread evenly over the map. Reserved pixels are never queued
+// until RB_releaseReservedPixels is called, so they're filled in after everything else.
+void RB_reservePixels(RB_PixelMap*, double fraction);
+
+// The number of pixels that are reserved and haven't been set or released yet.
+RB_Size RB_getNumReservedPixels(RB_PixelMap*);
+
+// Lets the reserved pixels be queued, and queues the ones that are next to a set pixel. Returns false if that didn't
+// queue any pixels.
+bool RB_releaseReservedPixels(RB_PixelMap*, RB_AssignmentQueue*);
+
 #endif
\ No newline at end of file
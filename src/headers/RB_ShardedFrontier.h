@@ -0,0 +1,45 @@
+#ifndef EKW_RAINBOW_RB_SHARDED_FRONTIER_H
+#define EKW_RAINBOW_RB_SHARDED_FRONTIER_H
+
+#include "RB_Main.h"
+#include "RB_BasicTypes.h"
+#include <stdbool.h>
+
+/*
+A frontier of coords waiting to be assigned a color, split into shards that can be used by several threads at once.
+The canvas is cut into a grid of tiles, one per shard, and each coord is queued in the shard whose tile contains it.
+Each shard has its own lock, so a worker thread that mostly works in its own shard never waits on the others. When its
+shard runs dry, a worker steals from the other shards, nearest tiles first.
+Every coord has an atomic state, so a coord is queued at most once, and once taken it is never queued again.
+*/
+typedef struct RB_ShardedFrontier_s RB_ShardedFrontier;
+
+// Allocates a frontier for a canvas of the specified size, split into numShards shards. Each shard's random choices
+// are seeded from the seed.
+RB_ShardedFrontier* RB_createShardedFrontier(RB_Size width, RB_Size height, int numShards, unsigned int seed);
+
+// Frees a previously allocated frontier. No other thread may be using it.
+void RB_freeShardedFrontier(RB_ShardedFrontier*);
+
+int RB_getNumFrontierShards(RB_ShardedFrontier*);
+
+// Returns the shard whose tile contains the coord.
+int RB_getFrontierShard(RB_ShardedFrontier*, RB_Coord);
+
+// The number of coords that are queued and haven't been taken yet. Other threads may change it at any time.
+RB_Size RB_getFrontierSize(RB_ShardedFrontier*);
+
+// Queues the coord in its shard, unless it has already been queued or taken. Returns true if this call queued it.
+// Safe to call from any number of threads at once.
+bool RB_addCoordToFrontier(RB_ShardedFrontier*, RB_Coord);
+
+// Marks the coord as taken without going through a shard, for instance when a seed pixel is set directly. It will
+// never be returned by RB_takeCoordFromFrontier. Returns false if it was already taken.
+// Safe to call from any number of threads at once.
+bool RB_claimCoordInFrontier(RB_ShardedFrontier*, RB_Coord);
+
+// Takes a random queued coord from the specified shard, or, if that shard is empty, from the nearest shard that isn't.
+// Safe to call from any number of threads at once. Returns false if every shard was empty.
+bool RB_takeCoordFromFrontier(RB_ShardedFrontier*, int shard, RB_Coord* out);
+
+#endif
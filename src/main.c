@@ -36,12 +36,19 @@ int main(int argc, char** argv) {
 	RB_setColorResolution(config, rRes, gRes, bRes);
 	RB_setWindowDimensions(config, 720, 720);
 
+	// Two fronts that grow towards each other from opposite edges, the right one twice as fast.
+	// int leftFront = RB_addGrowthFront(config, "left", 1);
+	// int rightFront = RB_addGrowthFront(config, "right", 2);
+	// RB_setFrontScheduling(config, RB_FRONT_SCHEDULING_WEIGHTED);
+
 
 
 	RB_Data* rainbow = RB_init(config);
 
-	RB_setCoordColor(rainbow, RB_getRandomCoord(rainbow), RB_getRandomColor(rainbow));
-	// RB_setCoordColor(rainbow, RB_getRandomCoord(rainbow), RB_getRandomColor(rainbow));
+	RB_setCoordColor(rainbow, RB_getRandomCoord(rainbow), RB_getRandomAvailableColor(rainbow));
+	// RB_setCoordColor(rainbow, RB_getRandomCoord(rainbow), RB_getRandomAvailableColor(rainbow));
+	// RB_setCoordColorInFront(rainbow, leftFront, (RB_Coord) { .x = 0, .y = rainbow->config.height / 2 }, RB_getRandomAvailableColor(rainbow));
+	// RB_setCoordColorInFront(rainbow, rightFront, (RB_Coord) { .x = rainbow->config.width - 1, .y = rainbow->config.height / 2 }, RB_getRandomAvailableColor(rainbow));
 
 	// RB_Color startColor = {
 	// 	.r = (0 * rRes) / 255,
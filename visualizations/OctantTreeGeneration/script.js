@@ -27,6 +27,118 @@ dimensionForm.elements["apply-button"].addEventListener("click", function() {
 	}
 });
 
+// LOADING REAL TREES
+// The JSON written by RB_exportColorPoolTree. See basicColorPool.c for the format.
+let treeDumpForm = document.getElementById("tree-dump-form");
+let treeDumpLevels = document.getElementById("tree-dump-levels");
+let treeDumpField = document.getElementById("tree-dump-field");
+let treeDump = null;
+
+treeDumpForm.elements["tree-dump-input"].addEventListener("change", function() {
+	const file = this.files[0];
+
+	if(file === undefined) {
+		return;
+	}
+
+	file.text().then((text) => {
+		treeDump = JSON.parse(text);
+		showTreeDumpLevels(treeDump);
+		drawTreeDumpLevel(treeDump, 0);
+	}).catch((error) => {
+		alert(`Could not load ${file.name}: ${error}`);
+	});
+});
+
+treeDumpForm.elements["tree-dump-level-select"].addEventListener("change", function() {
+	if(treeDump !== null) {
+		drawTreeDumpLevel(treeDump, Number.parseInt(this.value));
+	}
+});
+
+function showTreeDumpLevels(dump) {
+	while(treeDumpLevels.firstChild) {
+		treeDumpLevels.lastChild.remove();
+	}
+
+	let levelSelect = treeDumpForm.elements["tree-dump-level-select"];
+	while(levelSelect.firstChild) {
+		levelSelect.lastChild.remove();
+	}
+
+	const headings = ["depth", "octants", "blocks", "available", "expansions", "expansions per octant", "children (0-8)"];
+	let headerRow = treeDumpLevels.insertRow();
+	for(const heading of headings) {
+		let cell = document.createElement("th");
+		cell.textContent = heading;
+		headerRow.appendChild(cell);
+	}
+
+	for(const level of dump.levels) {
+		const expansionsPerOctant = (level.numOctants > 0)? (level.numExpansions / level.numOctants).toFixed(1) : "-";
+		const values = [
+			level.depth,
+			level.numOctants,
+			level.numBlocks,
+			level.numAvailable,
+			level.numExpansions,
+			expansionsPerOctant,
+			level.childCounts.join(" ")
+		];
+
+		let row = treeDumpLevels.insertRow();
+		for(const value of values) {
+			row.insertCell().textContent = value;
+		}
+
+		if(level.octants !== undefined) {
+			let option = document.createElement("option");
+			option.value = level.depth;
+			option.textContent = level.depth;
+			levelSelect.appendChild(option);
+		}
+	}
+}
+
+// Draws the level's octants projected onto the red-green plane. Darker octants were expanded by more searches, and
+// the outline gets thinner as the octant fills with fewer available colors than its bounds could hold.
+function drawTreeDumpLevel(dump, depth) {
+	while(treeDumpField.firstChild) {
+		treeDumpField.lastChild.remove();
+	}
+
+	const level = dump.levels[depth];
+
+	if(level === undefined || level.octants === undefined) {
+		return;
+	}
+
+	treeDumpField.setAttribute("viewBox", `${dump.minCorner[0]}, ${dump.minCorner[1]}, ${dump.maxCorner[0] - dump.minCorner[0] + 1}, ${dump.maxCorner[1] - dump.minCorner[1] + 1}`);
+
+	const maxExpansions = Math.max(1, ...level.octants.map((octant) => octant[8]));
+
+	for(const [minR, minG, minB, maxR, maxG, maxB, numChildren, numAvailable, numExpansions] of level.octants) {
+		const volume = (maxR - minR + 1) * (maxG - minG + 1) * (maxB - minB + 1);
+
+		let rect = document.createElementNS(SVGNS, "rect");
+		rect.setAttribute("x", minR);
+		rect.setAttribute("y", minG);
+		rect.setAttribute("width", maxR - minR + 1);
+		rect.setAttribute("height", maxG - minG + 1);
+		rect.setAttribute("fill", "black");
+		rect.setAttribute("fill-opacity", 0.05 + (0.95 * numExpansions / maxExpansions));
+		rect.setAttribute("stroke", "red");
+		rect.setAttribute("stroke-width", 0.5 * Math.min(1, numAvailable / volume));
+
+		let title = document.createElementNS(SVGNS, "title");
+		title.textContent = `[${minR}, ${minG}, ${minB}] to [${maxR}, ${maxG}, ${maxB}]\n` +
+			`${numChildren} children, ${numAvailable} available, ${numExpansions} expansions`;
+		rect.appendChild(title);
+
+		treeDumpField.appendChild(rect);
+	}
+}
+
 // fieldControls.elements["field-last-step-button"].addEventListener("click", () => {
 
 // });